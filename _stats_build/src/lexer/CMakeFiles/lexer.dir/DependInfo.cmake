@@ -0,0 +1,32 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/lexer/ByteScanner.cpp" "src/lexer/CMakeFiles/lexer.dir/ByteScanner.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/ByteScanner.cpp.o.d"
+  "/root/repo/src/lexer/LexerStats.cpp" "src/lexer/CMakeFiles/lexer.dir/LexerStats.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/LexerStats.cpp.o.d"
+  "/root/repo/src/lexer/Matcher.cpp" "src/lexer/CMakeFiles/lexer.dir/Matcher.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/Matcher.cpp.o.d"
+  "/root/repo/src/lexer/Node.cpp" "src/lexer/CMakeFiles/lexer.dir/Node.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/Node.cpp.o.d"
+  "/root/repo/src/lexer/Payload.cpp" "src/lexer/CMakeFiles/lexer.dir/Payload.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/Payload.cpp.o.d"
+  "/root/repo/src/lexer/RegexLimits.cpp" "src/lexer/CMakeFiles/lexer.dir/RegexLimits.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/RegexLimits.cpp.o.d"
+  "/root/repo/src/lexer/RegexOptimizer.cpp" "src/lexer/CMakeFiles/lexer.dir/RegexOptimizer.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/RegexOptimizer.cpp.o.d"
+  "/root/repo/src/lexer/RegexParsing.cpp" "src/lexer/CMakeFiles/lexer.dir/RegexParsing.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/RegexParsing.cpp.o.d"
+  "/root/repo/src/lexer/ScanMemo.cpp" "src/lexer/CMakeFiles/lexer.dir/ScanMemo.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/ScanMemo.cpp.o.d"
+  "/root/repo/src/lexer/State.cpp" "src/lexer/CMakeFiles/lexer.dir/State.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/State.cpp.o.d"
+  "/root/repo/src/lexer/StateMachine.cpp" "src/lexer/CMakeFiles/lexer.dir/StateMachine.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/StateMachine.cpp.o.d"
+  "/root/repo/src/lexer/TokenCache.cpp" "src/lexer/CMakeFiles/lexer.dir/TokenCache.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/TokenCache.cpp.o.d"
+  "/root/repo/src/lexer/TokenDelta.cpp" "src/lexer/CMakeFiles/lexer.dir/TokenDelta.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/TokenDelta.cpp.o.d"
+  "/root/repo/src/lexer/TransitionTable.cpp" "src/lexer/CMakeFiles/lexer.dir/TransitionTable.cpp.o" "gcc" "src/lexer/CMakeFiles/lexer.dir/TransitionTable.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,37 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/lexer.dir/ByteScanner.cpp.o"
+  "CMakeFiles/lexer.dir/ByteScanner.cpp.o.d"
+  "CMakeFiles/lexer.dir/LexerStats.cpp.o"
+  "CMakeFiles/lexer.dir/LexerStats.cpp.o.d"
+  "CMakeFiles/lexer.dir/Matcher.cpp.o"
+  "CMakeFiles/lexer.dir/Matcher.cpp.o.d"
+  "CMakeFiles/lexer.dir/Node.cpp.o"
+  "CMakeFiles/lexer.dir/Node.cpp.o.d"
+  "CMakeFiles/lexer.dir/Payload.cpp.o"
+  "CMakeFiles/lexer.dir/Payload.cpp.o.d"
+  "CMakeFiles/lexer.dir/RegexLimits.cpp.o"
+  "CMakeFiles/lexer.dir/RegexLimits.cpp.o.d"
+  "CMakeFiles/lexer.dir/RegexOptimizer.cpp.o"
+  "CMakeFiles/lexer.dir/RegexOptimizer.cpp.o.d"
+  "CMakeFiles/lexer.dir/RegexParsing.cpp.o"
+  "CMakeFiles/lexer.dir/RegexParsing.cpp.o.d"
+  "CMakeFiles/lexer.dir/ScanMemo.cpp.o"
+  "CMakeFiles/lexer.dir/ScanMemo.cpp.o.d"
+  "CMakeFiles/lexer.dir/State.cpp.o"
+  "CMakeFiles/lexer.dir/State.cpp.o.d"
+  "CMakeFiles/lexer.dir/StateMachine.cpp.o"
+  "CMakeFiles/lexer.dir/StateMachine.cpp.o.d"
+  "CMakeFiles/lexer.dir/TokenCache.cpp.o"
+  "CMakeFiles/lexer.dir/TokenCache.cpp.o.d"
+  "CMakeFiles/lexer.dir/TokenDelta.cpp.o"
+  "CMakeFiles/lexer.dir/TokenDelta.cpp.o.d"
+  "CMakeFiles/lexer.dir/TransitionTable.cpp.o"
+  "CMakeFiles/lexer.dir/TransitionTable.cpp.o.d"
+  "liblexer.a"
+  "liblexer.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/lexer.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,29 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/parser/Cst.cpp" "src/parser/CMakeFiles/parser.dir/Cst.cpp.o" "gcc" "src/parser/CMakeFiles/parser.dir/Cst.cpp.o.d"
+  "/root/repo/src/parser/Earley.cpp" "src/parser/CMakeFiles/parser.dir/Earley.cpp.o" "gcc" "src/parser/CMakeFiles/parser.dir/Earley.cpp.o.d"
+  "/root/repo/src/parser/Forest.cpp" "src/parser/CMakeFiles/parser.dir/Forest.cpp.o" "gcc" "src/parser/CMakeFiles/parser.dir/Forest.cpp.o.d"
+  "/root/repo/src/parser/Grammar.cpp" "src/parser/CMakeFiles/parser.dir/Grammar.cpp.o" "gcc" "src/parser/CMakeFiles/parser.dir/Grammar.cpp.o.d"
+  "/root/repo/src/parser/IndentedStream.cpp" "src/parser/CMakeFiles/parser.dir/IndentedStream.cpp.o" "gcc" "src/parser/CMakeFiles/parser.dir/IndentedStream.cpp.o.d"
+  "/root/repo/src/parser/LRTable.cpp" "src/parser/CMakeFiles/parser.dir/LRTable.cpp.o" "gcc" "src/parser/CMakeFiles/parser.dir/LRTable.cpp.o.d"
+  "/root/repo/src/parser/Packrat.cpp" "src/parser/CMakeFiles/parser.dir/Packrat.cpp.o" "gcc" "src/parser/CMakeFiles/parser.dir/Packrat.cpp.o.d"
+  "/root/repo/src/parser/ParseContext.cpp" "src/parser/CMakeFiles/parser.dir/ParseContext.cpp.o" "gcc" "src/parser/CMakeFiles/parser.dir/ParseContext.cpp.o.d"
+  "/root/repo/src/parser/ParseTable.cpp" "src/parser/CMakeFiles/parser.dir/ParseTable.cpp.o" "gcc" "src/parser/CMakeFiles/parser.dir/ParseTable.cpp.o.d"
+  "/root/repo/src/parser/Production.cpp" "src/parser/CMakeFiles/parser.dir/Production.cpp.o" "gcc" "src/parser/CMakeFiles/parser.dir/Production.cpp.o.d"
+  "/root/repo/src/parser/Token.cpp" "src/parser/CMakeFiles/parser.dir/Token.cpp.o" "gcc" "src/parser/CMakeFiles/parser.dir/Token.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,31 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/parser.dir/Cst.cpp.o"
+  "CMakeFiles/parser.dir/Cst.cpp.o.d"
+  "CMakeFiles/parser.dir/Earley.cpp.o"
+  "CMakeFiles/parser.dir/Earley.cpp.o.d"
+  "CMakeFiles/parser.dir/Forest.cpp.o"
+  "CMakeFiles/parser.dir/Forest.cpp.o.d"
+  "CMakeFiles/parser.dir/Grammar.cpp.o"
+  "CMakeFiles/parser.dir/Grammar.cpp.o.d"
+  "CMakeFiles/parser.dir/IndentedStream.cpp.o"
+  "CMakeFiles/parser.dir/IndentedStream.cpp.o.d"
+  "CMakeFiles/parser.dir/LRTable.cpp.o"
+  "CMakeFiles/parser.dir/LRTable.cpp.o.d"
+  "CMakeFiles/parser.dir/Packrat.cpp.o"
+  "CMakeFiles/parser.dir/Packrat.cpp.o.d"
+  "CMakeFiles/parser.dir/ParseContext.cpp.o"
+  "CMakeFiles/parser.dir/ParseContext.cpp.o.d"
+  "CMakeFiles/parser.dir/ParseTable.cpp.o"
+  "CMakeFiles/parser.dir/ParseTable.cpp.o.d"
+  "CMakeFiles/parser.dir/Production.cpp.o"
+  "CMakeFiles/parser.dir/Production.cpp.o.d"
+  "CMakeFiles/parser.dir/Token.cpp.o"
+  "CMakeFiles/parser.dir/Token.cpp.o.d"
+  "libparser.a"
+  "libparser.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/parser.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,12 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_regex.dir/test_regex.cpp.o"
+  "CMakeFiles/test_regex.dir/test_regex.cpp.o.d"
+  "test_regex"
+  "test_regex.pdb"
+  "test_regex[1]_tests.cmake"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_regex.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/tests
+# Build directory: /root/repo/_stats_build/tests
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+include("/root/repo/_stats_build/tests/test_combined[1]_include.cmake")
+include("/root/repo/_stats_build/tests/test_lexer[1]_include.cmake")
+include("/root/repo/_stats_build/tests/test_parser[1]_include.cmake")
+include("/root/repo/_stats_build/tests/test_regex[1]_include.cmake")
+subdirs("../_deps/googletest-build")
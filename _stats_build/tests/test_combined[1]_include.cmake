@@ -0,0 +1,5 @@
+if(EXISTS "/root/repo/_stats_build/tests/test_combined[1]_tests.cmake")
+  include("/root/repo/_stats_build/tests/test_combined[1]_tests.cmake")
+else()
+  add_test(test_combined_NOT_BUILT test_combined_NOT_BUILT)
+endif()
@@ -0,0 +1,9 @@
+add_test([=[TestCombined.IfElse]=]  /root/repo/_stats_build/tests/test_combined [==[--gtest_filter=TestCombined.IfElse]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestCombined.IfElse]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestCombined.TokenIds]=]  /root/repo/_stats_build/tests/test_combined [==[--gtest_filter=TestCombined.TokenIds]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestCombined.TokenIds]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestCombined.CachedTokens]=]  /root/repo/_stats_build/tests/test_combined [==[--gtest_filter=TestCombined.CachedTokens]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestCombined.CachedTokens]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestCombined.DeepNesting]=]  /root/repo/_stats_build/tests/test_combined [==[--gtest_filter=TestCombined.DeepNesting]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestCombined.DeepNesting]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+set(  test_combined_TESTS TestCombined.IfElse TestCombined.TokenIds TestCombined.CachedTokens TestCombined.DeepNesting)
@@ -0,0 +1,35 @@
+add_test([=[TestLexer.Literals]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.Literals]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.Literals]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.Stats]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.Stats]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.Stats]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.StatsMerge]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.StatsMerge]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.StatsMerge]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.RepeatedTokenize]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.RepeatedTokenize]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.RepeatedTokenize]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.SharedCompiledLexer]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.SharedCompiledLexer]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.SharedCompiledLexer]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.StaticLexer]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.StaticLexer]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.StaticLexer]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.OrderedAlternatives]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.OrderedAlternatives]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.OrderedAlternatives]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.MaximalMunch]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.MaximalMunch]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.MaximalMunch]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.SelfLoopRuns]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.SelfLoopRuns]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.SelfLoopRuns]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.Captures]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.Captures]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.Captures]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.ProfiledLayout]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.ProfiledLayout]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.ProfiledLayout]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.Batch]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.Batch]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.Batch]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.PushMode]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.PushMode]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.PushMode]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.RuntimeRules]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.RuntimeRules]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.RuntimeRules]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.TokenCache]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.TokenCache]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.TokenCache]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.Payloads]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.Payloads]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.Payloads]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestLexer.Relex]=]  /root/repo/_stats_build/tests/test_lexer [==[--gtest_filter=TestLexer.Relex]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestLexer.Relex]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+set(  test_lexer_TESTS TestLexer.Literals TestLexer.Stats TestLexer.StatsMerge TestLexer.RepeatedTokenize TestLexer.SharedCompiledLexer TestLexer.StaticLexer TestLexer.OrderedAlternatives TestLexer.MaximalMunch TestLexer.SelfLoopRuns TestLexer.Captures TestLexer.ProfiledLayout TestLexer.Batch TestLexer.PushMode TestLexer.RuntimeRules TestLexer.TokenCache TestLexer.Payloads TestLexer.Relex)
@@ -0,0 +1,31 @@
+add_test([=[TestParser.IfElse]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.IfElse]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.IfElse]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.TokenIds]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.TokenIds]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.TokenIds]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.GrammarSets]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.GrammarSets]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.GrammarSets]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.DeepGrammar]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.DeepGrammar]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.DeepGrammar]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.SharedGoal]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.SharedGoal]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.SharedGoal]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.ParseTable]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.ParseTable]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.ParseTable]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.LRTable]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.LRTable]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.LRTable]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.LRTableMatchesProduce]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.LRTableMatchesProduce]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.LRTableMatchesProduce]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.LRTableConflicts]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.LRTableConflicts]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.LRTableConflicts]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.Packrat]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.Packrat]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.Packrat]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.PackratMemo]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.PackratMemo]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.PackratMemo]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.Earley]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.Earley]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.Earley]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.EarleyMatchesPackrat]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.EarleyMatchesPackrat]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.EarleyMatchesPackrat]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.EarleyRightRecursion]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.EarleyRightRecursion]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.EarleyRightRecursion]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestParser.Cst]=]  /root/repo/_stats_build/tests/test_parser [==[--gtest_filter=TestParser.Cst]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestParser.Cst]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+set(  test_parser_TESTS TestParser.IfElse TestParser.TokenIds TestParser.GrammarSets TestParser.DeepGrammar TestParser.SharedGoal TestParser.ParseTable TestParser.LRTable TestParser.LRTableMatchesProduce TestParser.LRTableConflicts TestParser.Packrat TestParser.PackratMemo TestParser.Earley TestParser.EarleyMatchesPackrat TestParser.EarleyRightRecursion TestParser.Cst)
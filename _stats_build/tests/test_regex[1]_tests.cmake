@@ -0,0 +1,17 @@
+add_test([=[TestRegex.Tokenization]=]  /root/repo/_stats_build/tests/test_regex [==[--gtest_filter=TestRegex.Tokenization]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestRegex.Tokenization]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestRegex.ValidationFail]=]  /root/repo/_stats_build/tests/test_regex [==[--gtest_filter=TestRegex.ValidationFail]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestRegex.ValidationFail]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestRegex.ValidationPass]=]  /root/repo/_stats_build/tests/test_regex [==[--gtest_filter=TestRegex.ValidationPass]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestRegex.ValidationPass]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestRegex.Construction]=]  /root/repo/_stats_build/tests/test_regex [==[--gtest_filter=TestRegex.Construction]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestRegex.Construction]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestRegex.Optimization]=]  /root/repo/_stats_build/tests/test_regex [==[--gtest_filter=TestRegex.Optimization]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestRegex.Optimization]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestRegex.OptimizationKeepsStops]=]  /root/repo/_stats_build/tests/test_regex [==[--gtest_filter=TestRegex.OptimizationKeepsStops]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestRegex.OptimizationKeepsStops]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestRegex.Matcher]=]  /root/repo/_stats_build/tests/test_regex [==[--gtest_filter=TestRegex.Matcher]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestRegex.Matcher]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[TestRegex.Limits]=]  /root/repo/_stats_build/tests/test_regex [==[--gtest_filter=TestRegex.Limits]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[TestRegex.Limits]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_stats_build/tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+set(  test_regex_TESTS TestRegex.Tokenization TestRegex.ValidationFail TestRegex.ValidationPass TestRegex.Construction TestRegex.Optimization TestRegex.OptimizationKeepsStops TestRegex.Matcher TestRegex.Limits)
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <array>
+
+#include "lexer/State.hpp"
+
+namespace lexer {
+
+// Finds the end of a run of bytes from one CharSet. Sets that are a union of
+// at most maxRanges byte ranges are checked 16 bytes at a time with SSE2
+// compares; anything else, or a target without SSE2, uses a lookup table.
+class ByteScanner {
+  public:
+    static constexpr unsigned maxRanges = 8;
+
+    ByteScanner(const CharSet &chars);
+
+    // Returns the first position in [begin, end) whose byte is not in the
+    // set, or end.
+    auto skip(const char *begin, const char *end) const -> const char *;
+
+  private:
+    struct Range {
+        unsigned char lo;
+        unsigned char width; // hi - lo
+    };
+
+    std::array<bool, 256> member{};
+    std::array<Range, maxRanges> ranges{};
+    unsigned rangeCount = 0;
+    bool vectorized = false;
+};
+
+} // namespace lexer
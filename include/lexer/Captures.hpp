@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace lexer {
+
+// Submatch offsets into a token's text, recorded while the token was lexed.
+// Group 0 is the whole token and groups 1 and up are the ( ) groups of the
+// rule's regex in the order of their (. Offsets of a group that took no part
+// in the match are -1.
+struct Captures {
+    std::vector<long> offsets; // begin and end of each group
+
+    auto size() const -> unsigned
+    {
+        return static_cast<unsigned>(offsets.size() / 2);
+    }
+    auto begin(unsigned group) const -> long { return offsets[2 * group]; }
+    auto end(unsigned group) const -> long { return offsets[2 * group + 1]; }
+    auto matched(unsigned group) const -> bool
+    {
+        return group < size() && begin(group) >= 0 && end(group) >= begin(group);
+    }
+    // The text of group within text, or an empty view if it did not match.
+    auto view(std::string_view text, unsigned group) const -> std::string_view
+    {
+        if (!matched(group)) {
+            return {};
+        }
+        return text.substr(static_cast<std::size_t>(begin(group)),
+                           static_cast<std::size_t>(end(group) - begin(group)));
+    }
+};
+
+} // namespace lexer
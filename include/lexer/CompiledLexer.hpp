@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lexer/Captures.hpp"
+#include "lexer/LexerStats.hpp"
+#include "lexer/Payload.hpp"
+#include "lexer/TokenCache.hpp"
+#include "lexer/TokenDelta.hpp"
+#include "lexer/TransitionTable.hpp"
+
+namespace lexer {
+
+template<typename Token>
+class LexSession;
+template<typename Token>
+class Lexer;
+
+// A compiled set of token rules. A CompiledLexer is never modified once it is
+// built, so one instance can be shared by any number of threads, each
+// tokenizing through its own LexSession. Changing the rules means building a
+// new one, which a Lexer does.
+template<typename Token>
+class CompiledLexer {
+  public:
+    using Transition = std::function<int(int, char)>;
+    using Constructor =
+        std::function<std::unique_ptr<Token>(const std::string &)>;
+    using CaptureConstructor = std::function<std::unique_ptr<Token>(
+        const std::string &, const Captures &)>;
+    using PayloadConstructor =
+        std::function<std::unique_ptr<Token>(const Payload &)>;
+
+    struct Rule {
+        Transition transition{};
+        Constructor constructor{};
+        std::string pattern{};    // empty if the rule was given a Transition
+        unsigned long states = 0; // 0 if the automaton size is unknown
+        // The table behind transition for regex rules, used to skip runs
+        // of self-looping bytes. nullptr if the rule was given a Transition.
+        std::shared_ptr<const TransitionTable> table{};
+        // Used instead of constructor if set. The rule's table then records
+        // the submatch offsets of its capture groups.
+        CaptureConstructor captureConstructor{};
+        // Used instead of either if set. The token's bytes are decoded as
+        // payloadKind and the constructor is given the value.
+        PayloadConstructor payloadConstructor{};
+        Payload::Kind payloadKind = Payload::Decimal;
+        // Set if the rule never makes a token, like the whitespace rule. Its
+        // matches are then not constructed and not cached.
+        bool skip = false;
+    };
+
+    // The state order of each rule's table, hottest first, in the table's
+    // original state numbers. Empty for rules given a Transition. A layout
+    // can be kept from a profiling run and applied to later compiles of the
+    // same rules.
+    using Layout = std::vector<std::vector<int>>;
+
+    CompiledLexer(std::vector<Rule> rules);
+
+    auto rules() const -> const std::vector<Rule> & { return ruleList; }
+    auto stats() const -> const LexerStats & { return info; }
+
+    // Tokenizes sample and orders each table's states by how often they
+    // were visited.
+    auto profile(std::string_view sample) const -> Layout;
+    auto layout() const -> Layout;
+    // A copy with every table renumbered to layout. Entries that do not fit
+    // their rule's table, e.g. after the rule changed, are ignored.
+    auto withLayout(const Layout &layout) const -> CompiledLexer;
+
+    auto tokenize(std::istream &is) const
+        -> std::vector<std::unique_ptr<Token>>;
+    auto tokenize(std::string_view text) const
+        -> std::vector<std::unique_ptr<Token>>;
+
+    // Where the tokens of text are, without constructing them.
+    auto scan(std::string_view text) const -> std::vector<TokenSpan>;
+    // The change edit made to old, the spans of text before the edit. See
+    // LexSession::relex.
+    auto relex(const std::vector<TokenSpan> &old,
+               std::string_view text,
+               const Edit &edit) const -> TokenDelta;
+    // The spans of text encoded for reading back with a TokenStream.
+    auto cache(std::string_view text) const -> std::string;
+    // The token rule would make from source[begin, end), including the
+    // captures it would record there.
+    auto construct(unsigned rule,
+                   std::string_view source,
+                   std::size_t begin,
+                   std::size_t end) const -> std::unique_ptr<Token>;
+    // A hash of the rule patterns, for telling whether a cached token stream
+    // came from this lexer. Rules given a Transition are only counted.
+    auto fingerprint() const -> std::uint64_t;
+
+  private:
+    friend class Lexer<Token>;
+
+    // rule with its table renumbered to order, or unchanged if order does
+    // not fit the table.
+    static auto withOrder(Rule rule, const std::vector<int> &order) -> Rule;
+
+    std::vector<Rule> ruleList;
+    LexerStats info;
+};
+
+} // namespace lexer
+
+#include "lexer/CompiledLexer.tpp" // IWYU pragma: keep
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "lexer/CompiledLexer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <istream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "lexer/Captures.hpp"
+#include "lexer/LexSession.hpp"
+#include "lexer/Payload.hpp"
+#include "lexer/State.hpp"
+#include "lexer/TokenCache.hpp"
+#include "lexer/TokenDelta.hpp"
+#include "lexer/TransitionTable.hpp"
+
+template<typename Token>
+lexer::CompiledLexer<Token>::CompiledLexer(std::vector<Rule> rules)
+    : ruleList(std::move(rules))
+{
+    for (const Rule &rule : ruleList) {
+        info.rules.push_back({rule.pattern, rule.states});
+    }
+}
+
+template<typename Token>
+auto lexer::CompiledLexer<Token>::profile(std::string_view sample) const
+    -> Layout
+{
+    LexSession<Token> session(*this);
+    session.visits.resize(ruleList.size());
+    for (std::size_t i = 0; i < ruleList.size(); i++) {
+        if (ruleList[i].table != nullptr) {
+            session.visits[i].resize(ruleList[i].table->size());
+        }
+    }
+    session.tokenize(sample);
+
+    Layout result(ruleList.size());
+    for (std::size_t i = 0; i < ruleList.size(); i++) {
+        const TransitionTable *table = ruleList[i].table.get();
+        if (table == nullptr) {
+            continue;
+        }
+        const std::vector<unsigned long> &counts = session.visits[i];
+        std::vector<int> states(table->size());
+        std::iota(states.begin(), states.end(), 0);
+        std::stable_sort(states.begin() + State::Reject + 1, states.end(),
+                         [&](int a, int b) { return counts[a] > counts[b]; });
+        for (int &s : states) {
+            s = table->order()[s];
+        }
+        result[i] = std::move(states);
+    }
+    return result;
+}
+
+template<typename Token>
+auto lexer::CompiledLexer<Token>::layout() const -> Layout
+{
+    Layout result(ruleList.size());
+    for (std::size_t i = 0; i < ruleList.size(); i++) {
+        if (ruleList[i].table != nullptr) {
+            result[i] = ruleList[i].table->order();
+        }
+    }
+    return result;
+}
+
+template<typename Token>
+auto lexer::CompiledLexer<Token>::withLayout(const Layout &layout) const
+    -> CompiledLexer
+{
+    std::vector<Rule> rules = ruleList;
+    for (std::size_t i = 0; i < rules.size() && i < layout.size(); i++) {
+        rules[i] = withOrder(std::move(rules[i]), layout[i]);
+    }
+    return CompiledLexer(std::move(rules));
+}
+
+template<typename Token>
+auto lexer::CompiledLexer<Token>::withOrder(Rule rule,
+                                           const std::vector<int> &order)
+    -> Rule
+{
+    if (rule.table == nullptr || !rule.table->validOrder(order)) {
+        return rule;
+    }
+    auto table =
+        std::make_shared<const TransitionTable>(rule.table->reordered(order));
+    rule.transition = [table](int s, char c) {
+        return table->transition(s, c);
+    };
+    rule.table = std::move(table);
+    return rule;
+}
+
+template<typename Token>
+auto lexer::CompiledLexer<Token>::tokenize(std::istream &is) const
+    -> std::vector<std::unique_ptr<Token>>
+{
+    LexSession<Token> session(*this);
+    return session.tokenize(is);
+}
+
+template<typename Token>
+auto lexer::CompiledLexer<Token>::tokenize(std::string_view text) const
+    -> std::vector<std::unique_ptr<Token>>
+{
+    LexSession<Token> session(*this);
+    return session.tokenize(text);
+}
+
+template<typename Token>
+auto lexer::CompiledLexer<Token>::scan(std::string_view text) const
+    -> std::vector<TokenSpan>
+{
+    LexSession<Token> session(*this);
+    return session.scan(text);
+}
+
+template<typename Token>
+auto lexer::CompiledLexer<Token>::relex(const std::vector<TokenSpan> &old,
+                                        std::string_view text,
+                                        const Edit &edit) const -> TokenDelta
+{
+    LexSession<Token> session(*this);
+    return session.relex(old, text, edit);
+}
+
+template<typename Token>
+auto lexer::CompiledLexer<Token>::cache(std::string_view text) const
+    -> std::string
+{
+    return encodeSpans(scan(text), contentHash(text), fingerprint());
+}
+
+template<typename Token>
+auto lexer::CompiledLexer<Token>::construct(unsigned rule,
+                                            std::string_view source,
+                                            std::size_t begin,
+                                            std::size_t end) const
+    -> std::unique_ptr<Token>
+{
+    const Rule &r = ruleList[rule];
+    if (r.payloadConstructor) {
+        Payload payload;
+        payload.decode(r.payloadKind, source.substr(begin, end - begin));
+        return r.payloadConstructor(payload);
+    }
+    std::string text(source.substr(begin, end - begin));
+    if (!r.captureConstructor) {
+        return r.constructor(text);
+    }
+
+    // Replay the rule's table over the token and the byte after it, which
+    // is where the closing tags are recorded.
+    Captures captures;
+    std::size_t slots = r.table != nullptr ? r.table->slotCount() : 0;
+    captures.offsets.assign(std::max<std::size_t>(slots, 2), -1);
+    if (slots > 0) {
+        int state = State::Enter;
+        for (std::size_t i = begin; i <= end; i++) {
+            int c = EOF;
+            if (i < source.size() && source[i] != '\0') {
+                c = static_cast<unsigned char>(source[i]);
+            }
+            for (unsigned slot : r.table->tags(state, static_cast<char>(c))) {
+                captures.offsets[slot] = static_cast<long>(i - begin);
+            }
+            state = r.table->transition(state, static_cast<char>(c));
+        }
+    }
+    captures.offsets[0] = 0;
+    captures.offsets[1] = static_cast<long>(text.size());
+    return r.captureConstructor(text, captures);
+}
+
+template<typename Token>
+auto lexer::CompiledLexer<Token>::fingerprint() const -> std::uint64_t
+{
+    std::uint64_t hash = contentHash(std::to_string(ruleList.size()));
+    for (const Rule &rule : ruleList) {
+        hash = contentHash(rule.pattern, hash);
+        char flags[] = {'\0', rule.skip ? 's' : '-',
+                        rule.captureConstructor ? 'c' : '-',
+                        rule.payloadConstructor
+                            ? static_cast<char>('0' + rule.payloadKind)
+                            : '-'};
+        hash = contentHash(std::string_view(flags, sizeof(flags)), hash);
+    }
+    return hash;
+}
+
+// vim:ft=cpp
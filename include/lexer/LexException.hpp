@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cctype>
+#include <cstdio>
 #include <exception>
+#include <sstream>
 #include <string>
 
 namespace lexer {
@@ -21,6 +24,22 @@ class LexException : public std::exception {
     }
     auto what() const noexcept -> const char * override { return msg.c_str(); }
 
+    static auto unexpected(unsigned long line,
+                           unsigned long col,
+                           int c) -> LexException
+    {
+        std::stringstream ss;
+        ss << "Unexpected character ";
+        if (c == EOF) {
+            ss << "EOF";
+        } else if (isprint(c)) {
+            ss << "`" << (char)c << "`";
+        } else {
+            ss << "0x" << std::hex << (int)c << std::dec;
+        }
+        return {line, col, ss.str()};
+    }
+
   private:
     std::string msg;
 };
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "lexer/Captures.hpp"
+#include "lexer/CompiledLexer.hpp"
+#include "lexer/LexerStats.hpp"
+#include "lexer/Payload.hpp"
+#include "lexer/ScanMemo.hpp"
+#include "lexer/Source.hpp"
+#include "lexer/TokenBatch.hpp"
+#include "lexer/TokenCache.hpp"
+#include "lexer/TokenDelta.hpp"
+#include "lexer/TransitionTable.hpp"
+
+namespace lexer {
+
+// Per-run state for tokenizing with a CompiledLexer. A session owns the
+// position and scratch buffers, which are reused by every call to tokenize.
+// Sessions are cheap to create but must not be shared between threads.
+template<typename Token>
+class LexSession {
+  public:
+    // Number of records tokenizeBatch steps side by side.
+    static constexpr std::size_t batchLanes = 2;
+
+    // Only filled in when statsEnabled is set.
+    LexerStats stats;
+    // Visit counts per rule and state, collected for the rules whose list
+    // is sized before tokenizing. Used by CompiledLexer::profile.
+    std::vector<std::vector<unsigned long>> visits;
+
+    LexSession(const CompiledLexer<Token> &lexer);
+
+    // Tokens are the longest matches, ties going to the earliest rule. When
+    // every longer candidate dies part way, lexing falls back to the last
+    // token that did match and rescans from its end. Rescans are memoized,
+    // so tokenizing stays linear in the input.
+    auto tokenize(std::istream &is) -> std::vector<std::unique_ptr<Token>>;
+    auto tokenize(std::string_view text) -> std::vector<std::unique_ptr<Token>>;
+    // Tokenizes every record into out, replacing its contents. Records are
+    // stepped batchLanes at a time in one interleaved loop, so the table
+    // lookups of one record overlap those of the others. On a LexException
+    // the contents of out are unspecified.
+    void tokenizeBatch(const std::vector<std::string_view> &records,
+                       TokenBatch<Token> &out);
+
+    // Push-mode tokenizing for input that arrives in pieces. Each call to
+    // feed returns the tokens completed by chunk; the machine states, the
+    // partial token and the location carry over to the next call. finish
+    // ends the input, returning the last token, and readies the session
+    // for a new input. As with tokenize, a '\0' byte ends the input early
+    // and anything fed after it is ignored. After a LexException the
+    // current input is abandoned.
+    auto feed(std::string_view chunk) -> std::vector<std::unique_ptr<Token>>;
+    auto finish() -> std::vector<std::unique_ptr<Token>>;
+
+    // Where the tokens of text are, leaving out the matches of skip rules.
+    // No tokens are constructed.
+    auto scan(std::string_view text) -> std::vector<TokenSpan>;
+    // The change edit made to old, the spans of the text before the edit.
+    // text is the text after it. Lexing restarts at the last token whose
+    // predecessors never read as far as the edit and stops at the first
+    // token boundary past the edit that was also a boundary before it, so
+    // the cost follows the size of the edit and not of the text.
+    auto relex(const std::vector<TokenSpan> &old,
+               std::string_view text,
+               const Edit &edit) -> TokenDelta;
+    auto location() const -> const Location & { return loc; }
+
+  private:
+    // Bytes read from a stream at a time.
+    static constexpr std::size_t streamChunk = 4096;
+
+    // The state of every rule's machine for one input.
+    struct Machines {
+        std::vector<int> states;
+        // Capture slots of each rule; empty for rules without groups.
+        std::vector<std::vector<long>> slots;
+        int soleActive = -1; // the only machine still matching, if just one
+    };
+
+    // The outcome of stepping every machine over one byte.
+    struct Step {
+        bool stillMatching = false;
+        int firstAccepted = -1; // lowest rule whose token ended before it
+        int firstFinal = -1;    // lowest rule whose token may end after it
+    };
+
+    // One input being tokenized: a whole text, a record of tokenizeBatch
+    // or the bytes held back by feed.
+    struct Lane {
+        Machines machines;
+        std::size_t record = 0;
+        std::string_view text;
+        std::size_t base = 0;  // offset of text in the whole input
+        Location origin;       // location of the start of text
+        std::size_t pos = 0;   // offset of the next byte
+        std::size_t start = 0; // offset of the current token
+        // The longest token seen since start, or -1 if none. Scanning goes
+        // on past it while a longer one may match and falls back to it if
+        // none does.
+        int lastRule = -1;
+        std::size_t lastEnd = 0;
+        ScanMemo memo;
+        std::size_t reach = 0;      // one past the furthest byte read
+        std::size_t startReach = 0; // reach when the current token began
+        std::vector<std::unique_ptr<Token>> tokens;
+        std::vector<TokenSpan> *spans = nullptr; // if set, filled instead
+        bool busy = false; // holds a record
+        bool done = false; // the record is tokenized
+    };
+
+    auto transitionStates(Machines &m, std::size_t offset, char c) -> Step;
+    auto runLength(const Machines &m, std::string_view text, std::size_t pos)
+        -> std::size_t;
+    auto stateKey(const Machines &m) -> std::string_view;
+    void begin(Lane &lane, std::string_view text, std::size_t pos = 0);
+    auto stepLane(Lane &lane) -> bool;
+    void push(Lane &lane, std::string &bytes, std::string_view chunk);
+    void markAccept(Lane &lane, int rule, std::size_t end);
+    auto rollBack(Lane &lane, int c, bool matching) -> bool;
+    void emit(Lane &lane, int rule, std::size_t end, bool replay);
+    auto atEnd(const Lane &lane) const -> bool;
+    void countVisits(const Machines &m, unsigned long n);
+    void reset(Machines &m);
+    auto construct(int rule, std::string_view bytes, const Machines &m)
+        -> std::unique_ptr<Token>;
+
+    const CompiledLexer<Token> &lexer;
+    std::vector<const TransitionTable *> tables; // nullptr for Transitions
+    Machines machines;
+    bool capturing = false; // whether any rule has capture groups
+    Captures captures;
+    Payload payload;
+    std::string tokenText;
+    std::string key;
+    Location loc;
+    std::vector<Lane> lanes;
+    Lane pushed;          // the input of feed
+    std::string held;     // bytes fed since the start of pushed's token
+    bool feeding = false; // an input is part way through feed
+    bool fedEOF = false;  // feed has seen a '\0' byte
+};
+
+} // namespace lexer
+
+#include "lexer/LexSession.tpp" // IWYU pragma: keep
@@ -0,0 +1,682 @@
+#pragma once
+
+#include "lexer/LexSession.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "lexer/ByteScanner.hpp"
+#include "lexer/Captures.hpp"
+#include "lexer/CompiledLexer.hpp"
+#include "lexer/LexException.hpp"
+#include "lexer/ScanMemo.hpp"
+#include "lexer/Source.hpp"
+#include "lexer/State.hpp"
+#include "lexer/TokenBatch.hpp"
+#include "lexer/TokenCache.hpp"
+#include "lexer/TokenDelta.hpp"
+#include "lexer/TransitionTable.hpp"
+
+template<typename Token>
+lexer::LexSession<Token>::LexSession(const CompiledLexer<Token> &lexer)
+    : lexer(lexer)
+{
+    for (const auto &rule : lexer.rules()) {
+        tables.push_back(rule.table.get());
+        machines.states.push_back((int)State::Enter);
+        machines.slots.emplace_back(rule.table != nullptr
+                                            && rule.table->tagged()
+                                        ? rule.table->slotCount()
+                                        : 0,
+                                    -1);
+        capturing = capturing || !machines.slots.back().empty();
+    }
+    if constexpr (statsEnabled) {
+        stats = lexer.stats();
+    }
+}
+
+// The stream is read in chunks through push, as feed does, so only the bytes
+// from the current token's start on are held however long the input is.
+template<typename Token>
+auto lexer::LexSession<Token>::tokenize(std::istream &is)
+    -> std::vector<std::unique_ptr<Token>>
+{
+    std::chrono::steady_clock::time_point start;
+    if constexpr (statsEnabled) {
+        start = std::chrono::steady_clock::now();
+    }
+
+    Lane lane;
+    lane.machines = machines;
+    std::string bytes;
+    begin(lane, bytes);
+    std::string chunk(streamChunk, '\0');
+    while (is.read(chunk.data(), static_cast<std::streamsize>(chunk.size()))
+           || is.gcount() > 0)
+    {
+        std::string_view read(chunk.data(),
+                              static_cast<std::size_t>(is.gcount()));
+        std::size_t end = read.find('\0');
+        push(lane, bytes, read.substr(0, end));
+        if (end != std::string_view::npos) {
+            break;
+        }
+    }
+    if (!bytes.empty()) {
+        lane.text = bytes;
+        while (stepLane(lane)) {
+        }
+    }
+    loc = lane.origin;
+    loc.advance(bytes);
+
+    if constexpr (statsEnabled) {
+        stats.elapsed += std::chrono::steady_clock::now() - start;
+    }
+    return std::move(lane.tokens);
+}
+
+template<typename Token>
+auto lexer::LexSession<Token>::tokenize(std::string_view text)
+    -> std::vector<std::unique_ptr<Token>>
+{
+    std::chrono::steady_clock::time_point start;
+    if constexpr (statsEnabled) {
+        start = std::chrono::steady_clock::now();
+    }
+
+    text = text.substr(0, text.find('\0'));
+    Lane lane;
+    lane.machines = machines;
+    begin(lane, text);
+    if (!text.empty()) {
+        while (stepLane(lane)) {
+        }
+    }
+    loc = Location();
+    loc.advance(text);
+
+    if constexpr (statsEnabled) {
+        stats.elapsed += std::chrono::steady_clock::now() - start;
+    }
+    return std::move(lane.tokens);
+}
+
+// Steps every machine in m over c, which sits offset bytes into the current
+// token.
+template<typename Token>
+auto lexer::LexSession<Token>::transitionStates(Machines &m,
+                                                std::size_t offset,
+                                                char c) -> Step
+{
+    Step step;
+    unsigned long active = 0;
+    int lastActive = -1;
+
+    const auto &rules = lexer.rules();
+    std::vector<int> &states = m.states;
+    for (int i = 0; i < (int)states.size(); i++) {
+        if (capturing && !m.slots[i].empty()) {
+            for (unsigned slot : tables[i]->tags(states[i], c)) {
+                m.slots[i][slot] = static_cast<long>(offset);
+            }
+        }
+        states[i] = tables[i] != nullptr ? tables[i]->transition(states[i], c)
+                                         : rules[i].transition(states[i], c);
+        if (states[i] == (int)State::Accept) {
+            if (step.firstAccepted < 0) {
+                step.firstAccepted = i;
+            }
+        } else if (states[i] != (int)State::Reject) {
+            step.stillMatching = true;
+            active++;
+            lastActive = i;
+            // Only tables know their final states. A Transition shows that
+            // its token has ended one step later, by accepting.
+            if (step.firstFinal < 0 && tables[i] != nullptr
+                && tables[i]->final(states[i]))
+            {
+                step.firstFinal = i;
+            }
+        }
+    }
+    // A pending accept must see the next byte, so only skip when every
+    // other machine has rejected.
+    m.soleActive = active == 1 && step.firstAccepted < 0 ? lastActive : -1;
+
+    if constexpr (statsEnabled) {
+        stats.steps++;
+        stats.activeMachines += active;
+    }
+    return step;
+}
+
+// The number of bytes from pos on that the only live machine in m would loop
+// on. They can be consumed without stepping any machine.
+template<typename Token>
+auto lexer::LexSession<Token>::runLength(const Machines &m,
+                                         std::string_view text,
+                                         std::size_t pos) -> std::size_t
+{
+    if (m.soleActive < 0 || tables[m.soleActive] == nullptr) {
+        return 0;
+    }
+    const ByteScanner *scanner =
+        tables[m.soleActive]->selfLoop(m.states[m.soleActive]);
+    if (scanner == nullptr) {
+        return 0;
+    }
+    const char *begin = text.data() + pos;
+    auto n = static_cast<std::size_t>(
+        scanner->skip(begin, text.data() + text.size()) - begin);
+
+    if constexpr (statsEnabled) {
+        stats.steps += n;
+        stats.activeMachines += n;
+    }
+    return n;
+}
+
+// The rule and state of every machine still matching, which is all that
+// decides how the scan goes on.
+template<typename Token>
+auto lexer::LexSession<Token>::stateKey(const Machines &m) -> std::string_view
+{
+    key.clear();
+    for (int i = 0; i < (int)m.states.size(); i++) {
+        int state = m.states[i];
+        if (state == (int)State::Accept || state == (int)State::Reject) {
+            continue;
+        }
+        char bytes[2 * sizeof(int)];
+        std::memcpy(bytes, &i, sizeof(int));
+        std::memcpy(bytes + sizeof(int), &state, sizeof(int));
+        key.append(bytes, sizeof(bytes));
+    }
+    return key;
+}
+
+template<typename Token>
+void lexer::LexSession<Token>::countVisits(const Machines &m, unsigned long n)
+{
+    const std::vector<int> &states = m.states;
+    for (std::size_t i = 0; i < visits.size(); i++) {
+        if (!visits[i].empty() && states[i] < (int)visits[i].size()) {
+            visits[i][states[i]] += n;
+        }
+    }
+}
+
+template<typename Token>
+void lexer::LexSession<Token>::reset(Machines &m)
+{
+    for (int &state : m.states) {
+        state = (int)State::Enter;
+    }
+    for (std::vector<long> &ruleSlots : m.slots) {
+        std::fill(ruleSlots.begin(), ruleSlots.end(), -1);
+    }
+}
+
+// Makes rule's token from its bytes, which are only copied into a string for
+// rules that take the text.
+template<typename Token>
+auto lexer::LexSession<Token>::construct(int rule,
+                                         std::string_view bytes,
+                                         const Machines &m)
+    -> std::unique_ptr<Token>
+{
+    const auto &r = lexer.rules()[rule];
+    if (r.payloadConstructor) {
+        payload.decode(r.payloadKind, bytes);
+        return r.payloadConstructor(payload);
+    }
+    tokenText.assign(bytes.data(), bytes.size());
+    if (!r.captureConstructor) {
+        return r.constructor(tokenText);
+    }
+    captures.offsets.assign(m.slots[rule].begin(), m.slots[rule].end());
+    if (captures.offsets.size() < 2) {
+        captures.offsets.resize(2);
+    }
+    captures.offsets[0] = 0;
+    captures.offsets[1] = static_cast<long>(tokenText.size());
+    return r.captureConstructor(tokenText, captures);
+}
+
+// Readies lane to tokenize text from pos, keeping its machines' storage.
+// Tokens left over from an input that threw are dropped.
+template<typename Token>
+void lexer::LexSession<Token>::begin(Lane &lane,
+                                     std::string_view text,
+                                     std::size_t pos)
+{
+    reset(lane.machines);
+    lane.tokens.clear();
+    lane.text = text;
+    lane.base = 0;
+    lane.origin = Location();
+    lane.pos = pos;
+    lane.start = pos;
+    lane.lastRule = -1;
+    lane.memo.clear();
+    lane.reach = 0;
+    lane.startReach = 0;
+}
+
+// Whether the lane has no bytes left to read.
+template<typename Token>
+auto lexer::LexSession<Token>::atEnd(const Lane &lane) const -> bool
+{
+    return lane.pos >= lane.text.size() || lane.text[lane.pos] == '\0';
+}
+
+// Steps lane over its next byte, emitting a token if one ends there. Returns
+// false once the lane's text is finished.
+template<typename Token>
+auto lexer::LexSession<Token>::stepLane(Lane &lane) -> bool
+{
+    int c = atEnd(lane) ? EOF : static_cast<unsigned char>(lane.text[lane.pos]);
+    lane.reach = std::max(lane.reach, lane.pos + 1);
+    Step step = transitionStates(lane.machines, lane.pos - lane.start, c);
+    if (!visits.empty()) {
+        countVisits(lane.machines, 1);
+    }
+
+    if (!step.stillMatching) {
+        if (step.firstAccepted < 0) {
+            return rollBack(lane, c, false);
+        }
+        emit(lane, step.firstAccepted, lane.pos, false);
+        return c != EOF;
+    }
+    if (c == EOF) {
+        return rollBack(lane, c, true);
+    }
+
+    if (step.firstAccepted >= 0 && lane.pos > lane.start) {
+        markAccept(lane, step.firstAccepted, lane.pos);
+    }
+    lane.pos++;
+    if (step.firstFinal >= 0) {
+        markAccept(lane, step.firstFinal, lane.pos);
+    }
+
+    // Past the last accept, a state known to lead nowhere from here on is
+    // given up at once instead of being scanned again to find out.
+    bool lookingAhead = lane.lastRule >= 0 && lane.lastEnd < lane.pos;
+    std::string_view k;
+    std::size_t limit = lane.text.size();
+    if (lookingAhead) {
+        k = stateKey(lane.machines);
+        if (!lane.memo.empty()) {
+            std::size_t dead = lane.memo.deadFrom(k, lane.base + lane.pos);
+            if (dead == lane.base + lane.pos) {
+                return rollBack(lane, c, true);
+            }
+            limit = std::min(limit, dead - lane.base);
+        }
+    }
+    std::size_t n = runLength(lane.machines, lane.text.substr(0, limit),
+                              lane.pos);
+    if (lookingAhead) {
+        lane.memo.visit(k, lane.base + lane.pos, lane.base + lane.pos + n);
+        if (lane.pos + n == limit && limit < lane.text.size()) {
+            return rollBack(lane, c, true);
+        }
+    }
+    if (n > 0) {
+        if (!visits.empty()) {
+            countVisits(lane.machines, n);
+        }
+        lane.pos += n;
+        if (step.firstFinal >= 0) {
+            markAccept(lane, step.firstFinal, lane.pos);
+        }
+    }
+    return true;
+}
+
+// Notes that rule's token may end at end, which is longer than any token
+// noted before.
+template<typename Token>
+void lexer::LexSession<Token>::markAccept(Lane &lane, int rule, std::size_t end)
+{
+    lane.lastRule = rule;
+    lane.lastEnd = end;
+    lane.memo.accept();
+}
+
+// Every machine died, or the input ended, without a token ending on c. Emits
+// the last token seen and rescans from its end, or throws if there was none.
+template<typename Token>
+auto lexer::LexSession<Token>::rollBack(Lane &lane, int c, bool matching)
+    -> bool
+{
+    if (lane.lastRule < 0) {
+        // Locations are only needed for errors, so they are worked out here
+        // instead of being tracked per byte.
+        loc = lane.origin;
+        loc.advance(lane.text.substr(0, lane.pos));
+        if (matching) {
+            throw LexException(loc.line, loc.col, "Unexpected EOF");
+        }
+        if (c != EOF) {
+            loc.advance(c);
+        }
+        throw LexException::unexpected(loc.line, loc.col, c);
+    }
+    if constexpr (statsEnabled) {
+        stats.rollbacks++;
+    }
+    lane.memo.fail();
+    emit(lane, lane.lastRule, lane.lastEnd, true);
+    return !atEnd(lane);
+}
+
+// Ends the current token of lane at end and starts the next one there. The
+// machines only hold the token's captures if no byte past end was read, so
+// a rolled-back token is replayed to find them.
+template<typename Token>
+void lexer::LexSession<Token>::emit(Lane &lane,
+                                    int rule,
+                                    std::size_t end,
+                                    bool replay)
+{
+    if constexpr (statsEnabled) {
+        stats.rules[rule].tokens++;
+        stats.rules[rule].bytes += end - lane.start;
+    }
+
+    const auto &r = lexer.rules()[rule];
+    if (r.skip) {
+        // Nothing to make.
+    } else if (lane.spans != nullptr) {
+        TokenSpan span{static_cast<unsigned>(rule), lane.start, end};
+        span.reach = lane.startReach;
+        lane.spans->push_back(span);
+    } else {
+        std::unique_ptr<Token> token =
+            replay && r.captureConstructor
+                ? lexer.construct(static_cast<unsigned>(rule), lane.text,
+                                  lane.start, end)
+                : construct(rule, lane.text.substr(lane.start, end - lane.start),
+                            lane.machines);
+        if (token != nullptr) {
+            lane.tokens.push_back(std::move(token));
+        }
+    }
+    reset(lane.machines);
+    lane.start = end;
+    lane.pos = end;
+    lane.lastRule = -1;
+    lane.startReach = lane.reach;
+}
+
+template<typename Token>
+void lexer::LexSession<Token>::tokenizeBatch(
+    const std::vector<std::string_view> &records,
+    TokenBatch<Token> &out)
+{
+    std::chrono::steady_clock::time_point start;
+    if constexpr (statsEnabled) {
+        start = std::chrono::steady_clock::now();
+    }
+
+    if (lanes.empty()) {
+        lanes.resize(batchLanes);
+        for (Lane &lane : lanes) {
+            lane.machines = machines;
+        }
+    }
+    out.tokens.clear();
+    out.offsets.clear();
+    out.offsets.push_back(0);
+
+    // Records are handed out in order. A lane that finishes early holds on
+    // to its tokens until every earlier record has been written out, so the
+    // output never needs reordering.
+    std::size_t nextRecord = 0;
+    auto assign = [&](Lane &lane) {
+        lane.busy = nextRecord < records.size();
+        if (!lane.busy) {
+            return;
+        }
+        lane.record = nextRecord++;
+        begin(lane, records[lane.record]);
+        lane.done = atEnd(lane);
+    };
+    for (Lane &lane : lanes) {
+        assign(lane);
+    }
+
+    std::size_t nextOut = 0;
+    while (nextOut < records.size()) {
+        for (Lane &lane : lanes) {
+            if (lane.busy && !lane.done) {
+                lane.done = !stepLane(lane);
+            }
+        }
+        for (bool progress = true; progress;) {
+            progress = false;
+            for (Lane &lane : lanes) {
+                if (!lane.busy || !lane.done || lane.record != nextOut) {
+                    continue;
+                }
+                std::move(lane.tokens.begin(), lane.tokens.end(),
+                          std::back_inserter(out.tokens));
+                lane.tokens.clear();
+                out.offsets.push_back(out.tokens.size());
+                nextOut++;
+                assign(lane);
+                progress = true;
+            }
+        }
+    }
+
+    if constexpr (statsEnabled) {
+        stats.elapsed += std::chrono::steady_clock::now() - start;
+    }
+}
+
+// Appends chunk to bytes, the input of lane from its current token on, and
+// steps over all of it. The bytes of a token stay held until it is emitted,
+// since rolling back may need them; those of emitted tokens are dropped, and
+// so is what the memo knew about them. Only the end of the held bytes is ever
+// stepped over here; the machines wait there for the next chunk.
+template<typename Token>
+void lexer::LexSession<Token>::push(Lane &lane,
+                                    std::string &bytes,
+                                    std::string_view chunk)
+{
+    bytes.append(chunk);
+    lane.text = bytes;
+    while (lane.pos < bytes.size()) {
+        stepLane(lane);
+    }
+
+    std::size_t done = lane.start;
+    if (done > 0) {
+        lane.origin.advance(std::string_view(bytes).substr(0, done));
+        bytes.erase(0, done);
+        lane.text = bytes;
+        lane.base += done;
+        lane.pos -= done;
+        lane.start = 0;
+        lane.lastEnd -= std::min(lane.lastEnd, done);
+        lane.reach -= done;
+        lane.startReach -= std::min(lane.startReach, done);
+        if (!lane.memo.empty()) {
+            lane.memo.forget(lane.base);
+        }
+    }
+}
+
+template<typename Token>
+auto lexer::LexSession<Token>::feed(std::string_view chunk)
+    -> std::vector<std::unique_ptr<Token>>
+{
+    std::chrono::steady_clock::time_point start;
+    if constexpr (statsEnabled) {
+        start = std::chrono::steady_clock::now();
+    }
+
+    if (!feeding) {
+        if (pushed.machines.states.empty()) {
+            pushed.machines = machines;
+        }
+        held.clear();
+        begin(pushed, held);
+        feeding = true;
+        fedEOF = false;
+    }
+    if (fedEOF) {
+        return {};
+    }
+    std::size_t end = chunk.find('\0');
+    if (end != std::string_view::npos) {
+        fedEOF = true;
+        chunk = chunk.substr(0, end);
+    }
+
+    try {
+        push(pushed, held, chunk);
+    } catch (...) {
+        feeding = false;
+        throw;
+    }
+
+    if constexpr (statsEnabled) {
+        stats.elapsed += std::chrono::steady_clock::now() - start;
+    }
+    return std::move(pushed.tokens);
+}
+
+template<typename Token>
+auto lexer::LexSession<Token>::finish() -> std::vector<std::unique_ptr<Token>>
+{
+    std::vector<std::unique_ptr<Token>> tokens;
+    // Held bytes belong to a token that only the end of the input can end.
+    if (feeding && !held.empty()) {
+        pushed.text = held;
+        try {
+            while (stepLane(pushed)) {
+            }
+        } catch (...) {
+            feeding = false;
+            throw;
+        }
+        tokens = std::move(pushed.tokens);
+    }
+    pushed.tokens.clear();
+    feeding = false;
+    held.clear();
+    return tokens;
+}
+
+template<typename Token>
+auto lexer::LexSession<Token>::scan(std::string_view text)
+    -> std::vector<TokenSpan>
+{
+    std::vector<TokenSpan> spans;
+    Lane lane;
+    lane.machines = machines;
+    begin(lane, text);
+    lane.spans = &spans;
+    if (atEnd(lane)) {
+        return spans;
+    }
+    while (stepLane(lane)) {
+    }
+    return spans;
+}
+
+// Whether a token of the old stream started at pos: either a span begins
+// there or one ends there, ahead of a span or a skipped match.
+static auto startsToken(const std::vector<lexer::TokenSpan> &spans,
+                        std::size_t pos) -> bool
+{
+    auto it = std::lower_bound(
+        spans.begin(), spans.end(), pos,
+        [](const lexer::TokenSpan &s, std::size_t p) { return s.begin < p; });
+    return (it != spans.end() && it->begin == pos)
+           || (it != spans.begin() && std::prev(it)->end == pos);
+}
+
+template<typename Token>
+auto lexer::LexSession<Token>::relex(const std::vector<TokenSpan> &old,
+                                     std::string_view text,
+                                     const Edit &edit) -> TokenDelta
+{
+    TokenDelta delta;
+    delta.shift =
+        static_cast<long>(edit.inserted) - static_cast<long>(edit.removed);
+
+    // The tokens before a span that never read as far as the edit cannot
+    // have changed. Reaches only grow along the stream.
+    auto after = std::partition_point(
+        old.begin(), old.end(),
+        [&](const TokenSpan &s) { return s.reach <= edit.offset; });
+    std::size_t restart = 0;
+    std::size_t reach = 0;
+    if (after != old.begin()) {
+        delta.first = static_cast<std::size_t>(after - old.begin()) - 1;
+        restart = old[delta.first].begin;
+        reach = old[delta.first].reach;
+    }
+
+    Lane lane;
+    lane.machines = machines;
+    begin(lane, text, restart);
+    lane.reach = reach;
+    lane.startReach = reach;
+    lane.spans = &delta.inserted;
+
+    std::size_t editEnd = edit.offset + edit.inserted;
+    std::size_t kept = old.size();
+    bool more = !atEnd(lane);
+    while (more) {
+        std::size_t start = lane.start;
+        more = stepLane(lane);
+        if (lane.start == start || lane.start < editEnd) {
+            continue;
+        }
+        // From a token boundary on, lexing only depends on the bytes that
+        // follow. Past the edit those are the old bytes, so once a boundary
+        // lines up with an old one, the rest of the old stream holds. The
+        // reaches of the old spans must also still cover how far the new
+        // tokens read.
+        std::size_t oldPos = lane.start + edit.removed - edit.inserted;
+        if (!startsToken(old, oldPos)) {
+            continue;
+        }
+        std::size_t next = static_cast<std::size_t>(
+            std::lower_bound(old.begin(), old.end(), oldPos,
+                             [](const TokenSpan &s, std::size_t p) {
+                                 return s.begin < p;
+                             })
+            - old.begin());
+        if (next < old.size() && old[next].reach != TokenSpan::unknown
+            && lane.reach + edit.removed > old[next].reach + edit.inserted)
+        {
+            continue;
+        }
+        kept = next;
+        break;
+    }
+    delta.removed = kept - delta.first;
+    return delta;
+}
+
+// vim:ft=cpp
@@ -4,49 +4,108 @@
 #include <istream>
 #include <memory>
 #include <string>
-#include <utility>
+#include <string_view>
 #include <vector>
 
+#include "lexer/CompiledLexer.hpp"
+#include "lexer/LexSession.hpp"
+#include "lexer/LexerStats.hpp"
+#include "lexer/Payload.hpp"
+#include "lexer/RegexLimits.hpp"
+
 namespace lexer {
 
+// Collects token rules and compiles them into a CompiledLexer. Lexer keeps the
+// last compiled lexer around, so repeated calls to tokenize do not rebuild it.
+// Rules added or removed later are patched into a copy of its rules one at a
+// time, since every rule has its own automaton, and the next tokenize builds
+// a new CompiledLexer from them without recompiling the others.
 template<typename Token>
 class Lexer {
   public:
-    using Transition = std::function<int(int, char)>;
-    using Constructor =
-        std::function<std::unique_ptr<Token>(const std::string &)>;
+    using Transition = typename CompiledLexer<Token>::Transition;
+    using Constructor = typename CompiledLexer<Token>::Constructor;
+    using CaptureConstructor =
+        typename CompiledLexer<Token>::CaptureConstructor;
+    using PayloadConstructor =
+        typename CompiledLexer<Token>::PayloadConstructor;
+    using Layout = typename CompiledLexer<Token>::Layout;
 
     struct {
         bool ignoreWhitespace = false;
     } opts;
 
+    // Automaton sizes are recorded when the rules are compiled; counters and
+    // timings are only collected when statsEnabled is set.
+    LexerStats stats;
+
+    // Applied to every table when the rules are compiled, and again by the
+    // next tokenize after it changes. Set by profile, or restored from an
+    // earlier run's layout.
+    Layout layout;
+
+    // Checked while compiling each regex rule added after they are set. A
+    // rule that exceeds them is not added, and addTokenType throws a
+    // RegexParsing::RegexException.
+    RegexParsing::Limits limits;
+
     Lexer() = default;
 
     void addTokenType(const Transition &transitionFn,
                       const Constructor &constructorFn);
     void addTokenType(const std::string &regex,
                       const Constructor &constructorFn);
+    // The constructor also receives the offsets of the regex's ( ) groups.
+    void addTokenType(const std::string &regex,
+                      const CaptureConstructor &constructorFn);
+    // The constructor is given the token's bytes decoded as kind.
+    void addTokenType(const std::string &regex,
+                      Payload::Kind kind,
+                      const PayloadConstructor &constructorFn);
     template<typename SubToken>
     void addTokenType(const Transition &transitionFn);
+    // If SubToken is constructible from (text, Captures), it is given the
+    // offsets of the regex's ( ) groups.
     template<typename SubToken>
     void addTokenType(const std::string &regex);
+    // SubToken must be constructible from a Payload.
+    template<typename SubToken>
+    void addTokenType(const std::string &regex, Payload::Kind kind);
     void addTokenType(const std::string &regex);
+    // Removes the most recently added rule for regex. Returns false if there
+    // is none.
+    auto removeTokenType(const std::string &regex) -> bool;
 
+    auto compile() const -> CompiledLexer<Token>;
+    // The kept lexer that tokenize runs, rebuilt first if the rules, options
+    // or layout changed. It stays valid until the next rebuild.
+    auto compiledLexer() -> const CompiledLexer<Token> &;
+    // Tokenizes sample to find the hot states of each rule, then packs them
+    // together at the front of their tables.
+    void profile(std::string_view sample);
     auto tokenize(std::istream &is) -> std::vector<std::unique_ptr<Token>>;
 
   private:
-    auto nextChar(std::istream &is) -> int;
-    auto transitionStates(std::vector<int> &states,
-                          char c) -> std::pair<bool, int>;
-    void handleOptions();
-
-    std::vector<std::function<int(int, char)>> transitionFns;
-    std::vector<std::function<std::unique_ptr<Token>(std::string)>>
-        constructorFns;
-    struct Location {
-        unsigned long line = 1;
-        unsigned long col = 0;
-    } loc;
+    using Rule = typename CompiledLexer<Token>::Rule;
+
+    void addRule(Rule rule);
+    static auto whitespaceRule() -> Rule;
+    static auto regexRule(const std::string &regex,
+                          const Constructor &constructorFn,
+                          const RegexParsing::Limits &limits) -> Rule;
+    static auto capturingRule(const std::string &regex,
+                              const CaptureConstructor &constructorFn,
+                              const RegexParsing::Limits &limits) -> Rule;
+
+    std::vector<Rule> rules;
+    // The rules of the last compiled lexer, laid out as keptLayout and with
+    // the whitespace rule, once kept is set. compiled is nullptr after they
+    // change.
+    std::vector<Rule> keptRules;
+    Layout keptLayout;
+    bool kept = false;
+    std::shared_ptr<const CompiledLexer<Token>> compiled;
+    bool compiledIgnoreWhitespace = false;
 };
 
 } // namespace lexer
@@ -2,58 +2,201 @@
 
 #include "lexer/Lexer.hpp"
 
-#include <cctype>
-#include <cstdio>
-#include <functional>
-#include <iostream>
+#include <algorithm>
+#include <cstddef>
 #include <istream>
 #include <memory>
-#include <sstream>
+#include <numeric>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
-#include "lexer/LexException.hpp"
+#include "lexer/Captures.hpp"
+#include "lexer/CompiledLexer.hpp"
+#include "lexer/LexSession.hpp"
+#include "lexer/Payload.hpp"
+#include "lexer/RegexLimits.hpp"
 #include "lexer/RegexParsing.hpp"
-#include "lexer/State.hpp"
 #include "lexer/StateMachine.hpp"
+#include "lexer/TokenTraits.hpp"
+#include "lexer/TransitionTable.hpp"
+
+// The kept rules, the layout and the stats all index rules in the order they
+// were added, so each is patched at the new rule's index. The whitespace rule,
+// if any, stays last.
+template<typename Token>
+void lexer::Lexer<Token>::addRule(Rule rule)
+{
+    std::size_t index = rules.size();
+    rules.push_back(std::move(rule));
+    if (index < layout.size()) {
+        layout.insert(layout.begin() + index, std::vector<int>());
+    }
+    if (index < stats.rules.size()) {
+        stats.rules.insert(stats.rules.begin() + index,
+                           {rules[index].pattern, rules[index].states});
+    }
+    if (kept) {
+        keptRules.insert(keptRules.begin() + index, rules[index]);
+        if (index < keptLayout.size()) {
+            keptLayout.insert(keptLayout.begin() + index, std::vector<int>());
+        }
+        compiled = nullptr;
+    }
+}
+
+template<typename Token>
+auto lexer::Lexer<Token>::removeTokenType(const std::string &regex) -> bool
+{
+    auto it = std::find_if(rules.rbegin(), rules.rend(),
+                           [&](const Rule &r) { return r.pattern == regex; });
+    if (it == rules.rend()) {
+        return false;
+    }
+    auto index = static_cast<std::size_t>(rules.rend() - it - 1);
+    rules.erase(rules.begin() + index);
+    if (index < layout.size()) {
+        layout.erase(layout.begin() + index);
+    }
+    if (index < stats.rules.size()) {
+        stats.rules.erase(stats.rules.begin() + index);
+    }
+    if (kept) {
+        keptRules.erase(keptRules.begin() + index);
+        if (index < keptLayout.size()) {
+            keptLayout.erase(keptLayout.begin() + index);
+        }
+        compiled = nullptr;
+    }
+    return true;
+}
+
+template<typename Token>
+auto lexer::Lexer<Token>::whitespaceRule() -> Rule
+{
+    Rule rule = regexRule(
+        R"([ \r\n\t\v]+)",
+        [](const std::string &) { return nullptr; },
+        RegexParsing::Limits());
+    rule.skip = true;
+    return rule;
+}
+
+template<typename Token>
+auto lexer::Lexer<Token>::regexRule(const std::string &regex,
+                                    const Constructor &constructorFn,
+                                    const RegexParsing::Limits &limits)
+    -> Rule
+{
+    RegexParsing::Budget budget(limits);
+    auto table = std::make_shared<const TransitionTable>(
+        StateMachine(RegexParsing::toNode(regex, budget)));
+    budget.checkDfaStates(table->size());
+    budget.checkTime();
+    return {[table](int s, char c) { return table->transition(s, c); },
+            constructorFn,
+            regex,
+            table->size(),
+            table};
+}
+
+template<typename Token>
+auto lexer::Lexer<Token>::capturingRule(
+    const std::string &regex,
+    const CaptureConstructor &constructorFn,
+    const RegexParsing::Limits &limits) -> Rule
+{
+    RegexParsing::Budget budget(limits);
+    auto table = std::make_shared<const TransitionTable>(
+        StateMachine(RegexParsing::toCapturingNode(regex, budget)));
+    budget.checkDfaStates(table->size());
+    budget.checkTime();
+    Rule rule{[table](int s, char c) { return table->transition(s, c); },
+              nullptr,
+              regex,
+              table->size(),
+              table};
+    rule.captureConstructor = constructorFn;
+    return rule;
+}
 
 template<typename Token>
 void lexer::Lexer<Token>::addTokenType(const Transition &transitionFn,
                                        const Constructor &constructorFn)
 {
-    transitionFns.push_back(transitionFn);
-    constructorFns.push_back(constructorFn);
+    addRule({transitionFn, constructorFn});
 }
 
 template<typename Token>
 void lexer::Lexer<Token>::addTokenType(const std::string &regex,
                                        const Constructor &constructorFn)
 {
-    StateMachine sm(RegexParsing::toNode(regex));
-    transitionFns.push_back(
-        [sm](int s, char c) { return sm.transition(s, c); });
-    constructorFns.push_back(constructorFn);
+    addRule(regexRule(regex, constructorFn, limits));
+}
+
+template<typename Token>
+void lexer::Lexer<Token>::addTokenType(
+    const std::string &regex,
+    const CaptureConstructor &constructorFn)
+{
+    addRule(capturingRule(regex, constructorFn, limits));
+}
+
+template<typename Token>
+void lexer::Lexer<Token>::addTokenType(const std::string &regex,
+                                       Payload::Kind kind,
+                                       const PayloadConstructor &constructorFn)
+{
+    Rule rule = regexRule(regex, nullptr, limits);
+    rule.payloadConstructor = constructorFn;
+    rule.payloadKind = kind;
+    addRule(std::move(rule));
 }
 
 template<typename Token>
 template<typename SubToken>
 void lexer::Lexer<Token>::addTokenType(const Transition &transitionFn)
 {
-    transitionFns.push_back(transitionFn);
-    constructorFns.push_back(
-        [](std::string text) { return std::make_unique<SubToken>(text); });
+    int id = registerTokenType<Token, SubToken>();
+    addRule({transitionFn, [id](const std::string &text) {
+                 return makeToken<Token, SubToken>(text, id);
+             }});
 }
 
 template<typename Token>
 template<typename SubToken>
 void lexer::Lexer<Token>::addTokenType(const std::string &regex)
 {
-    StateMachine sm(RegexParsing::toNode(regex));
-    transitionFns.push_back(
-        [sm](int s, char c) { return sm.transition(s, c); });
-    constructorFns.push_back(
-        [](std::string text) { return std::make_unique<SubToken>(text); });
+    int id = registerTokenType<Token, SubToken>();
+    if constexpr (takesCaptures<SubToken>) {
+        addRule(capturingRule(
+            regex,
+            [id](const std::string &text, const Captures &captures) {
+                return makeToken<Token, SubToken>(text, captures, id);
+            },
+            limits));
+    } else {
+        addRule(regexRule(
+            regex,
+            [id](const std::string &text) {
+                return makeToken<Token, SubToken>(text, id);
+            },
+            limits));
+    }
+}
+
+template<typename Token>
+template<typename SubToken>
+void lexer::Lexer<Token>::addTokenType(const std::string &regex,
+                                       Payload::Kind kind)
+{
+    static_assert(takesPayload<SubToken>,
+                  "SubToken must be constructible from a Payload");
+    int id = registerTokenType<Token, SubToken>();
+    addTokenType(regex, kind, [id](const Payload &payload) {
+        return makeToken<Token, SubToken>(payload, id);
+    });
 }
 
 template<typename Token>
@@ -63,119 +206,95 @@ void lexer::Lexer<Token>::addTokenType(const std::string &regex)
 }
 
 template<typename Token>
-auto lexer::Lexer<Token>::nextChar(std::istream &is) -> int
+auto lexer::Lexer<Token>::compile() const -> CompiledLexer<Token>
 {
-    if (is.eof()) {
-        return EOF;
-    }
-
-    int c = is.get();
-    if (c == '\0') {
-        return EOF;
-    }
-
-    if (c == '\n') {
-        loc.line++;
-        loc.col = 0;
-    } else {
-        loc.col++;
+    std::vector<Rule> compiledRules = rules;
+    if (opts.ignoreWhitespace) {
+        compiledRules.push_back(whitespaceRule());
     }
-    return c;
+    CompiledLexer<Token> result(std::move(compiledRules));
+    return layout.empty() ? result : result.withLayout(layout);
 }
 
+// Builds a fresh CompiledLexer from the kept rules whenever they or the
+// layout changed. Only a whitespace rule added back is compiled; the other
+// rules share their tables with the lexers built before, or are renumbered
+// to the new layout.
 template<typename Token>
-auto lexer::Lexer<Token>::transitionStates(std::vector<int> &states,
-                                           char c) -> std::pair<bool, int>
+auto lexer::Lexer<Token>::compiledLexer() -> const CompiledLexer<Token> &
 {
-    bool stillMatching = false;
-    int firstAcceptedState = -1;
-
-    for (int i = 0; i < (int)states.size(); i++) {
-        states[i] = transitionFns[i](states[i], c);
-        if (firstAcceptedState < 0 && states[i] == (int)State::Accept) {
-            firstAcceptedState = i;
+    if (!kept) {
+        auto fresh = std::make_shared<const CompiledLexer<Token>>(compile());
+        keptRules = fresh->rules();
+        keptLayout = layout;
+        kept = true;
+        compiledIgnoreWhitespace = opts.ignoreWhitespace;
+        compiled = std::move(fresh);
+        stats.merge(compiled->stats());
+        return *compiled;
+    }
+    if (compiledIgnoreWhitespace != opts.ignoreWhitespace) {
+        std::size_t index = rules.size();
+        if (opts.ignoreWhitespace) {
+            Rule ws = whitespaceRule();
+            if (index < layout.size()) {
+                ws = CompiledLexer<Token>::withOrder(ws, layout[index]);
+            }
+            keptRules.insert(keptRules.begin() + index, std::move(ws));
+        } else {
+            keptRules.erase(keptRules.begin() + index);
+            if (index < stats.rules.size()) {
+                stats.rules.erase(stats.rules.begin() + index);
+            }
         }
-        if (states[i] != (int)State::Accept && states[i] != (int)State::Reject)
-        {
-            stillMatching = true;
+        compiledIgnoreWhitespace = opts.ignoreWhitespace;
+        compiled = nullptr;
+    }
+    if (layout != keptLayout) {
+        // As in compile, an entry that does not fit its rule leaves the rule
+        // in its original order.
+        for (std::size_t i = 0; i < keptRules.size(); i++) {
+            const TransitionTable *table = keptRules[i].table.get();
+            if (table == nullptr) {
+                continue;
+            }
+            std::vector<int> order(table->size());
+            std::iota(order.begin(), order.end(), 0);
+            if (i < layout.size() && table->validOrder(layout[i])) {
+                order = layout[i];
+            }
+            keptRules[i] =
+                CompiledLexer<Token>::withOrder(std::move(keptRules[i]), order);
         }
+        keptLayout = layout;
+        compiled = nullptr;
     }
-
-    return {stillMatching, firstAcceptedState};
+    if (compiled == nullptr) {
+        compiled = std::make_shared<const CompiledLexer<Token>>(keptRules);
+        stats.merge(compiled->stats());
+    }
+    return *compiled;
 }
 
 template<typename Token>
-void lexer::Lexer<Token>::handleOptions()
+void lexer::Lexer<Token>::profile(std::string_view sample)
 {
-    if (opts.ignoreWhitespace) {
-        StateMachine ws(RegexParsing::toNode(R"([ \r\n\t\v]+)"));
-        addTokenType([ws](int s, char c) { return ws.transition(s, c); },
-                     [](const std::string &) { return nullptr; });
-    }
+    layout = compiledLexer().profile(sample);
+    compiled = std::make_shared<const CompiledLexer<Token>>(
+        compiled->withLayout(layout));
+    keptRules = compiled->rules();
+    keptLayout = layout;
 }
 
 template<typename Token>
 auto lexer::Lexer<Token>::tokenize(std::istream &is)
     -> std::vector<std::unique_ptr<Token>>
 {
-    handleOptions();
-    std::vector<std::unique_ptr<Token>> tokens;
-    std::vector<char> currToken;
-    std::vector<int> states(transitionFns.size(), (int)State::Enter);
-
-    std::function<void()> reset = [&currToken, &states]() {
-        currToken.clear();
-        for (int &state : states) {
-            state = (int)State::Enter;
-        }
-    };
-    reset();
-
-    int c = nextChar(is);
-    if (c == EOF) {
-        return tokens;
+    LexSession<Token> session(compiledLexer());
+    std::vector<std::unique_ptr<Token>> tokens = session.tokenize(is);
+    if constexpr (statsEnabled) {
+        stats.merge(session.stats);
     }
-    while (true) {
-        auto [stillMatching, firstAcceptedState] = transitionStates(states, c);
-
-        if (!stillMatching) {
-            if (firstAcceptedState < 0) {
-                std::stringstream ss;
-                ss << "Unexpected character ";
-                if (c == EOF) {
-                    ss << "EOF";
-                } else if (isprint(c)) {
-                    ss << "`" << (char)c << "`";
-                } else {
-                    ss << "0x" << std::hex << (int)c << std::dec;
-                }
-                throw lexer::LexException(loc.line, loc.col, ss.str());
-                return tokens;
-            }
-
-            std::string tokenText(currToken.begin(), currToken.end());
-            std::unique_ptr<Token> token =
-                constructorFns[firstAcceptedState](tokenText);
-            if (token != nullptr) {
-                tokens.push_back(std::move(token));
-            }
-            reset();
-
-            if (c == EOF) {
-                break;
-            }
-            continue;
-        }
-        if (c == EOF) {
-            std::cerr << "Unexpected EOF\n";
-            throw lexer::LexException(loc.line, loc.col, "Unexpected EOF");
-            break;
-        }
-
-        currToken.push_back(static_cast<char>(c));
-        c = nextChar(is);
-    }
-
     return tokens;
 }
 
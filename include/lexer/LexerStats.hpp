@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lexer {
+
+// Define QLANG_LEXER_STATS (or configure with -DQLANG_LEXER_STATS=ON) to make
+// Lexer collect runtime counters. When disabled, the counting code is removed
+// at compile time and only the per-rule automaton sizes are recorded.
+#ifdef QLANG_LEXER_STATS
+inline constexpr bool statsEnabled = true;
+#else
+inline constexpr bool statsEnabled = false;
+#endif
+
+struct LexerStats {
+    struct Rule {
+        std::string pattern; // empty for rules given as a Transition
+        unsigned long states = 0; // 0 if the automaton size is unknown
+        unsigned long tokens = 0;
+        unsigned long bytes = 0;
+    };
+
+    std::vector<Rule> rules;
+    unsigned long steps = 0;          // bytes fed through transitionStates
+    unsigned long activeMachines = 0; // machines still matching, summed
+    unsigned long rollbacks = 0; // tokens ended by backing up to an accept
+    std::chrono::nanoseconds elapsed{0};
+
+    auto averageActive() const -> double;
+    void clearCounters();
+    // Adds the counters of other to this, rule by rule. The pattern and size
+    // of each rule are taken from other, which has the current rule order.
+    void merge(const LexerStats &other);
+    auto toJson() const -> std::string;
+};
+
+auto operator<<(std::ostream &o, const LexerStats &s) -> std::ostream &;
+
+} // namespace lexer
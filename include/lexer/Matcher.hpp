@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lexer/ByteScanner.hpp"
+#include "lexer/RegexParsing.hpp"
+#include "lexer/State.hpp"
+
+namespace RegexParsing {
+
+// A regex compiled for searching text instead of tokenizing it, using the
+// same syntax as token rules. The automaton is determinized up front, so
+// matching costs one table load per byte. Candidate start positions are found
+// with memchr or a ByteScanner before the automaton is run. Matches are
+// leftmost-longest.
+class Matcher {
+  public:
+    struct Match {
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    // Throw a RegexException if the regex is malformed or compiling it
+    // exceeds limits. Determinizing can take time and space exponential in
+    // the regex, so limits.maxDfaStates is worth setting for untrusted input.
+    Matcher(const std::string &regex, const Limits &limits = Limits());
+    Matcher(const std::shared_ptr<Pattern> &p,
+            const Budget &budget = Budget());
+
+    auto fullMatch(std::string_view text) const -> bool;
+    // The first match that starts at or after from.
+    auto search(std::string_view text, std::size_t from = 0) const
+        -> std::optional<Match>;
+    // Appends every non-overlapping match to out and returns how many were
+    // found. out is not cleared, so one vector can serve many calls.
+    auto findAll(std::string_view text, std::vector<Match> &out) const
+        -> std::size_t;
+
+    auto size() const -> unsigned { return stateCount; }
+
+  private:
+    static constexpr int dead = 0;
+    static constexpr int start = 1;
+
+    Matcher(const std::string &regex, const Budget &budget);
+
+    auto step(int state, char c) const -> int
+    {
+        return next[state * classCount
+                    + byteClass[static_cast<unsigned char>(c)]];
+    }
+    auto candidate(std::string_view text, std::size_t pos) const
+        -> std::size_t;
+    auto longestAt(std::string_view text, std::size_t pos) const
+        -> std::optional<std::size_t>;
+    auto firstFrom(std::string_view text, std::size_t from) const
+        -> std::optional<Match>;
+
+    std::array<unsigned char, 256> byteClass{};
+    std::vector<int> next;
+    std::vector<char> accepting;
+    unsigned stateCount = 0;
+    unsigned classCount = 0;
+
+    std::string prefix;   // every match starts with this
+    std::string required; // every match contains this
+    lexer::CharSet firstBytes;
+    std::optional<lexer::ByteScanner> nonFirst; // skips bytes not in firstBytes
+};
+
+} // namespace RegexParsing
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <memory>
 #include <ostream>
 #include <vector>
 
@@ -8,58 +7,35 @@
 
 namespace lexer {
 
+// An NFA under construction. All states live in one arena, starting with the
+// Enter, Accept and Reject states. Sub-expressions are built as fragments,
+// which only record the entry and exit states of the sub-expression, and
+// are combined by adding edges between those states.
 struct Node {
-    std::vector<std::shared_ptr<State>> states;
-    std::vector<std::shared_ptr<State>> entry;
-    std::vector<std::shared_ptr<State>> exit;
-    virtual ~Node() = default;
-    virtual void connect() = 0;
+    struct Fragment {
+        std::vector<unsigned> entry;
+        std::vector<unsigned> exit;
+    };
 
-    friend auto operator<<(std::ostream &o, const Node &n) -> std::ostream &;
-    virtual void print(std::ostream &o) const;
-};
+    std::vector<State> states;
+    Fragment root;
 
-struct LiteralNode : Node {
-    LiteralNode(const std::shared_ptr<State> &s);
-    void connect() override;
-    void print(std::ostream &o) const override;
-};
+    Node();
 
-struct ConcatNode : Node {
-    std::unique_ptr<Node> left;
-    std::unique_ptr<Node> right;
-    ConcatNode(std::unique_ptr<Node> left, std::unique_ptr<Node> right);
-    void connect() override;
-    void print(std::ostream &o) const override;
-};
+    auto literal(const CharSet &chars) -> Fragment;
+    auto concat(Fragment left, Fragment right) -> Fragment;
+    auto alternate(std::vector<Fragment> alternatives) -> Fragment;
+    auto plus(Fragment opr) -> Fragment;
+    auto star(Fragment opr) -> Fragment;
+    auto optional(Fragment opr) -> Fragment;
 
-struct AlternateNode : Node {
-    std::unique_ptr<Node> left;
-    std::unique_ptr<Node> right;
-    AlternateNode(std::unique_ptr<Node> left, std::unique_ptr<Node> right);
-    void connect() override;
-    void print(std::ostream &o) const override;
-};
+    // Makes f capture group g: edges added from now on that enter or leave
+    // f carry the group's tags. Edges inside f were added before and do not.
+    void capture(const Fragment &f, unsigned group);
 
-struct PlusNode : Node {
-    std::unique_ptr<Node> opr;
-    PlusNode(std::unique_ptr<Node> opr);
-    void connect() override;
-    void print(std::ostream &o) const override;
+    void addEdge(unsigned from, unsigned to);
 };
 
-struct StarNode : Node {
-    std::unique_ptr<Node> opr;
-    StarNode(std::unique_ptr<Node> opr);
-    void connect() override;
-    void print(std::ostream &o) const override;
-};
-
-struct OptionalNode : Node {
-    std::unique_ptr<Node> opr;
-    OptionalNode(std::unique_ptr<Node> opr);
-    void connect() override;
-    void print(std::ostream &o) const override;
-};
+auto operator<<(std::ostream &o, const Node &n) -> std::ostream &;
 
 } // namespace lexer
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace lexer {
+
+// A typed value decoded from a token's bytes as the token is lexed, for rules
+// whose SubToken is constructed from the value instead of its text. The
+// decoder only reads the bytes of the winning rule, in place, so the token's
+// text is neither copied into a std::string nor parsed a second time.
+struct Payload {
+    enum Kind {
+        Decimal, // digits, e.g. 123
+        Hex,     // hex digits after an optional 0x or 0X, e.g. 0x1F
+        Float,   // digits with an optional fraction, e.g. 1.25
+        String,  // a quoted string; the body with its escapes resolved
+    };
+
+    Kind kind = Decimal;
+    std::uint64_t integer = 0; // Decimal and Hex
+    bool overflow = false;     // the integer did not fit in 64 bits
+    double real = 0;           // Float
+    std::string string;        // String
+
+    // Decodes text as kind into this payload. Bytes the kind does not
+    // expect end the value, e.g. a trailing suffix.
+    void decode(Kind kind, std::string_view text);
+};
+
+} // namespace lexer
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <exception>
+#include <string>
+
+namespace RegexParsing {
+
+// Thrown when a regex is malformed or compiling it exceeds one of its Limits.
+class RegexException : public std::exception {
+  public:
+    enum Kind {
+        Invalid,
+        TooLong,
+        TooDeep,
+        TooManyNfaStates,
+        TooManyDfaStates,
+        Timeout
+    };
+
+    RegexException(Kind kind, const std::string &detail)
+        : k(kind), msg("Regex error: " + detail)
+    {}
+    auto what() const noexcept -> const char * override { return msg.c_str(); }
+    auto kind() const -> Kind { return k; }
+
+  private:
+    Kind k;
+    std::string msg;
+};
+
+} // namespace RegexParsing
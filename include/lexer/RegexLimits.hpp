@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace RegexParsing {
+
+// Bounds on the work done to compile one regex, for patterns that come from
+// untrusted sources. A limit of zero means no limit. Parsing, optimizing and
+// building a pattern recurse once per piece, alternative and group, so the
+// length and nesting are bounded by default to stay well inside an 8 MB
+// stack; raise them only for trusted patterns or a larger stack.
+struct Limits {
+    std::size_t maxLength = 1024; // bytes of pattern text
+    unsigned maxNesting = 256;    // depth of ( ) groups
+    std::size_t maxNfaStates = 0;
+    std::size_t maxDfaStates = 0; // transition table or Matcher states
+    std::chrono::milliseconds maxCompileTime{0};
+};
+
+// Tracks one compile against its Limits, with the clock started at start,
+// by default when it is created. Each check throws a RegexException once its
+// limit is exceeded.
+class Budget {
+  public:
+    Budget(const Limits &limits = Limits(),
+           std::chrono::steady_clock::time_point start =
+               std::chrono::steady_clock::now());
+
+    void checkLength(std::size_t length) const;
+    void checkNesting(unsigned depth) const;
+    void checkNfaStates(std::size_t states) const;
+    void checkDfaStates(std::size_t states) const;
+    void checkTime() const;
+
+  private:
+    Limits limits;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+} // namespace RegexParsing
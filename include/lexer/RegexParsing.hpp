@@ -1,11 +1,14 @@
 #pragma once
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "lexer/Node.hpp"
+#include "lexer/RegexException.hpp" // IWYU pragma: export
+#include "lexer/RegexLimits.hpp"
 
 namespace RegexParsing {
 
@@ -24,20 +27,64 @@ struct Pattern {
         Alternate,
         Plus,
         Star,
-        Optional
+        Optional,
+        Literal
     } type;
 
     char literalChar = 0;
     std::function<bool(char)> charChoicePred;
+    lexer::CharSet charChoiceChars; // the bytes accepted by charChoicePred
+    std::string literal; // a run of Chars, only produced by optimize()
+    unsigned captures = 0; // number of ( ) pairs around exactly this pattern
     std::shared_ptr<Pattern> opr1;
     std::shared_ptr<Pattern> opr2;
 
     Pattern() = default;
+    // Throw a RegexException if the pattern is malformed or exceeds one of
+    // budget's limits.
     Pattern(const std::string &text);
     Pattern(const std::vector<int> &tokens);
+    Pattern(const std::string &text, const Budget &budget);
+    Pattern(const std::vector<int> &tokens, const Budget &budget);
+
+  private:
+    void parse(const std::vector<int> &tokens,
+               std::size_t begin,
+               std::size_t end,
+               const Budget &budget);
 };
 
+// The bytes matched by a Char or CharChoice pattern.
+auto charSet(const Pattern &p) -> lexer::CharSet;
+
+// How the automaton built from a pattern chooses among alternatives. A lexer
+// rule's StateMachine takes the First one that matches each byte and never
+// backtracks, so "a"|"ab" only matches a; a Matcher follows them All.
+enum class Alternatives { First, All };
+
+// Rewrites p into a pattern that builds a smaller automaton which behaves
+// the same under alternatives: alternatives are suffix-factored, and for All
+// prefix-factored, while for First those a rule can never take are dropped.
+// Adjacent single-character alternatives are merged into one choice, nested
+// quantifiers are collapsed and runs of Chars become Literals.
+auto optimize(const std::shared_ptr<Pattern> &p,
+              Alternatives alternatives = Alternatives::First)
+    -> std::shared_ptr<Pattern>;
+
+// toNode(text) optimizes the pattern first; toNode(p) builds p as given.
+// The budget overloads throw a RegexException once a limit is exceeded.
 auto toNode(const std::shared_ptr<Pattern> &p) -> std::unique_ptr<lexer::Node>;
+auto toNode(const std::shared_ptr<Pattern> &p, const Budget &budget)
+    -> std::unique_ptr<lexer::Node>;
 auto toNode(const std::string &text) -> std::unique_ptr<lexer::Node>;
+auto toNode(const std::string &text, const Budget &budget)
+    -> std::unique_ptr<lexer::Node>;
+
+// Builds text without optimizing it and tags the edges into and out of every
+// ( ) group, so a machine can record submatch offsets while it steps. Groups
+// are numbered from 1 in the order of their (.
+auto toCapturingNode(const std::string &text) -> std::unique_ptr<lexer::Node>;
+auto toCapturingNode(const std::string &text, const Budget &budget)
+    -> std::unique_ptr<lexer::Node>;
 
 } // namespace RegexParsing
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lexer {
+
+// Remembers where looking past the last accepted token was bound to fail, so
+// that rolling back to that token never scans the same ground twice. Once
+// the machines are known to die without accepting from a combined state at
+// some offset, every later scan that reaches that state there can roll back
+// at once. Each (state, offset) pair is thus scanned at most once past an
+// accept, which keeps tokenizing linear in the input (Reps, "Maximal-munch
+// tokenization in linear time", 1998).
+//
+// A state is a key built by the caller from the machines that are still
+// matching. Offsets are those of the byte the machines are about to read.
+class ScanMemo {
+  public:
+    // Notes that the machines were in state key at every offset in
+    // [begin, end], having read past the last accept.
+    void visit(std::string_view key, std::size_t begin, std::size_t end);
+    // The visits since the last accept led nowhere: remember them.
+    void fail();
+    // A token may end here, so the visits since the last accept were not in
+    // vain.
+    void accept()
+    {
+        if (!pending.empty()) {
+            pending.clear();
+            pendingKeys.clear();
+        }
+    }
+    // The first offset from at on where the machines in state key are known
+    // to die before accepting again, or npos if there is none. A scan that
+    // stays in state key, such as a run over a self-loop, need go no further.
+    auto deadFrom(std::string_view key, std::size_t at) const -> std::size_t;
+    auto empty() const -> bool { return dead.empty(); }
+    // Drops the ranges that end before offset. Scans only move forward, so
+    // once the current token starts at offset they can never be asked for.
+    void forget(std::size_t offset);
+    void clear();
+
+  private:
+    struct Visit {
+        std::size_t key; // offset into pendingKeys
+        std::size_t keySize;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    std::vector<Visit> pending;
+    std::string pendingKeys;
+    // Dead offset ranges per state, keyed by their first offset.
+    std::map<std::string, std::map<std::size_t, std::size_t>, std::less<>>
+        dead;
+};
+
+} // namespace lexer
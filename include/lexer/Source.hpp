@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace lexer {
+
+struct Location {
+    unsigned long line = 1;
+    unsigned long col = 0;
+
+    void advance(int c)
+    {
+        if (c == '\n') {
+            line++;
+            col = 0;
+        } else {
+            col++;
+        }
+    }
+
+    void advance(std::string_view run)
+    {
+        std::size_t lastNewline = run.rfind('\n');
+        if (lastNewline == std::string_view::npos) {
+            col += run.size();
+            return;
+        }
+        for (char c : run.substr(0, lastNewline + 1)) {
+            line += c == '\n';
+        }
+        col = run.size() - lastNewline - 1;
+    }
+};
+
+} // namespace lexer
@@ -1,58 +1,48 @@
 #pragma once
 
-#include <functional>
-#include <memory>
+#include <bitset>
 #include <ostream>
-#include <utility>
 #include <vector>
 
 namespace lexer {
 
-class State {
-  public:
+using CharSet = std::bitset<256>;
+
+// A state in an NFA arena. States refer to each other by index into the
+// arena, so a machine is a flat vector with no ownership cycles.
+struct State {
     enum {
         Enter = 0,
         Accept = 1,
         Reject = 2,
     };
-    unsigned id;
-
-    virtual ~State() = default;
-    void addEdge(const std::shared_ptr<State> &other);
-    auto transition(char c) const -> std::shared_ptr<State>;
-    virtual auto matches(char c) const -> bool = 0;
-    virtual auto isEpsilon() const -> bool { return false; }
-    void setRejector(std::shared_ptr<State> rejector)
+
+    CharSet chars; // bytes that lead into this state
+    bool epsilon = false;
+    std::vector<unsigned> successors;
+    std::vector<unsigned> epsilonSuccessors;
+
+    // Capture tags. Slot 2g holds the start of group g and slot 2g+1 its
+    // end. An edge into this state from outside a group it begins sets the
+    // openTags; an edge out of a group it ends sets the closeTags. The tags
+    // of each edge are fixed when the edge is added and are stored parallel
+    // to the successor lists; the lists stay empty while no edge has tags.
+    std::vector<unsigned> openTags;
+    std::vector<unsigned> closeTags;
+    std::vector<std::vector<unsigned>> successorTags;
+    std::vector<std::vector<unsigned>> epsilonSuccessorTags;
+
+    auto matches(char c) const -> bool
     {
-        this->rejector = std::move(rejector);
+        return chars.test(static_cast<unsigned char>(c));
+    }
+    auto isEpsilon() const -> bool { return epsilon; }
+    auto hasTags() const -> bool
+    {
+        return !successorTags.empty() || !epsilonSuccessorTags.empty();
     }
 
-    friend auto operator<<(std::ostream &o, const State &n) -> std::ostream &;
-    virtual void print(std::ostream &o) const;
-
-  protected:
-    std::vector<std::shared_ptr<State>> successors;
-    std::vector<std::shared_ptr<State>> epsilonSuccessors;
-    std::shared_ptr<State> rejector;
-};
-
-struct CharState : public State {
-    char literal;
-    CharState(char literal) : literal(literal) {}
-    auto matches(char c) const -> bool override { return c == literal; }
-};
-
-struct PredState : public State {
-    std::function<bool(char)> literal;
-    PredState(std::function<bool(char)> literal) : literal(std::move(literal))
-    {}
-    auto matches(char c) const -> bool override { return literal(c); }
-};
-
-struct EpsilonState : public State {
-    EpsilonState() = default;
-    auto isEpsilon() const -> bool override { return true; }
-    auto matches(char /*c*/) const -> bool override { return true; }
+    void print(std::ostream &o, unsigned id) const;
 };
 
 } // namespace lexer
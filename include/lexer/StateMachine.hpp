@@ -11,7 +11,15 @@ namespace lexer {
 struct StateMachine {
     StateMachine(std::unique_ptr<Node> n);
     auto transition(int state, char c) const -> int;
-    std::vector<std::shared_ptr<State>> states;
+    // Also appends the capture tags of the edges taken to tags.
+    auto transition(int state, char c, std::vector<unsigned> &tags) const
+        -> int;
+    auto hasTags() const -> bool;
+    std::vector<State> states;
+
+  private:
+    // Appends the tags taken to tags unless it is nullptr.
+    auto step(int state, char c, std::vector<unsigned> *tags) const -> int;
 };
 
 } // namespace lexer
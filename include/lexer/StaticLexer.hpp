@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "lexer/ScanMemo.hpp"
+#include "lexer/Source.hpp"
+#include "lexer/TokenTraits.hpp"
+#include "lexer/TransitionTable.hpp"
+
+namespace lexer {
+
+// A token rule for StaticLexer. Regex must name a constant character array,
+// e.g. `static constexpr char litDec[] = "[0-9]+";`. Tokens matched by a rule
+// whose SubToken is void are skipped.
+template<typename SubToken, const char *Regex>
+struct Rule {
+    using TokenType = SubToken;
+
+    static auto table() -> const TransitionTable &;
+};
+
+// A lexer over a token set that is fixed at compile time. Each rule is stepped
+// and constructed through its own type instead of a std::function, so the
+// compiler can inline the stepping loop.
+template<typename Token, typename... Rules>
+class StaticLexer {
+  public:
+    static_assert(sizeof...(Rules) > 0, "StaticLexer needs at least one rule");
+
+    StaticLexer()
+        : tables{&Rules::table()...},
+          ids{registerTokenType<Token, typename Rules::TokenType>()...}
+    {}
+
+    // Tokens are the longest matches, as with LexSession::tokenize.
+    auto tokenize(std::istream &is) -> std::vector<std::unique_ptr<Token>>;
+    auto tokenize(std::string_view text) -> std::vector<std::unique_ptr<Token>>;
+    auto location() const -> const Location & { return loc; }
+
+  private:
+    static constexpr std::size_t ruleCount = sizeof...(Rules);
+    // Bytes read from a stream at a time.
+    static constexpr std::size_t streamChunk = 4096;
+    using Indices = std::make_index_sequence<ruleCount>;
+
+    // The outcome of stepping every machine over one byte.
+    struct Step {
+        bool stillMatching = false;
+        int firstAccepted = -1; // lowest rule whose token ended before it
+        int firstFinal = -1;    // lowest rule whose token may end after it
+    };
+
+    auto run(std::string_view text, std::istream *is)
+        -> std::vector<std::unique_ptr<Token>>;
+    template<std::size_t... I>
+    auto transitionStates(char c, std::index_sequence<I...>) -> Step;
+    template<std::size_t... I>
+    auto construct(int rule,
+                   const std::string &text,
+                   std::index_sequence<I...>) -> std::unique_ptr<Token>;
+    auto runLength(std::string_view text, std::size_t pos) const
+        -> std::size_t;
+    auto stateKey() -> std::string_view;
+    void reset();
+
+    std::array<const TransitionTable *, ruleCount> tables;
+    std::array<int, ruleCount> ids;
+    std::array<int, ruleCount> states{};
+    int soleActive = -1; // the only machine still matching, if just one
+    std::string currToken;
+    std::string held; // bytes read from a stream, from the current token on
+    std::string key;
+    ScanMemo memo;
+    Location loc;
+};
+
+} // namespace lexer
+
+#include "lexer/StaticLexer.tpp" // IWYU pragma: keep
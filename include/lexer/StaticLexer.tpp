@@ -0,0 +1,283 @@
+#pragma once
+
+#include "lexer/StaticLexer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lexer/ByteScanner.hpp"
+#include "lexer/LexException.hpp"
+#include "lexer/RegexParsing.hpp"
+#include "lexer/ScanMemo.hpp"
+#include "lexer/Source.hpp"
+#include "lexer/State.hpp"
+#include "lexer/StateMachine.hpp"
+#include "lexer/TokenTraits.hpp"
+#include "lexer/TransitionTable.hpp"
+
+template<typename SubToken, const char *Regex>
+auto lexer::Rule<SubToken, Regex>::table() -> const TransitionTable &
+{
+    static const TransitionTable t(StateMachine(RegexParsing::toNode(Regex)));
+    return t;
+}
+
+template<typename Token, typename... Rules>
+auto lexer::StaticLexer<Token, Rules...>::tokenize(std::istream &is)
+    -> std::vector<std::unique_ptr<Token>>
+{
+    return run({}, &is);
+}
+
+template<typename Token, typename... Rules>
+auto lexer::StaticLexer<Token, Rules...>::tokenize(std::string_view text)
+    -> std::vector<std::unique_ptr<Token>>
+{
+    return run(text, nullptr);
+}
+
+template<typename Token, typename... Rules>
+template<std::size_t... I>
+auto lexer::StaticLexer<Token, Rules...>::transitionStates(
+    char c,
+    std::index_sequence<I...> /*indices*/) -> Step
+{
+    Step step;
+    unsigned active = 0;
+    int lastActive = -1;
+
+    (
+        [&] {
+            int s = tables[I]->transition(states[I], c);
+            states[I] = s;
+            if (s == (int)State::Accept) {
+                if (step.firstAccepted < 0) {
+                    step.firstAccepted = static_cast<int>(I);
+                }
+            } else if (s != (int)State::Reject) {
+                active++;
+                lastActive = static_cast<int>(I);
+                if (step.firstFinal < 0 && tables[I]->final(s)) {
+                    step.firstFinal = static_cast<int>(I);
+                }
+            }
+        }(),
+        ...);
+    soleActive = active == 1 && step.firstAccepted < 0 ? lastActive : -1;
+    step.stillMatching = active > 0;
+    return step;
+}
+
+template<typename Token, typename... Rules>
+template<std::size_t... I>
+auto lexer::StaticLexer<Token, Rules...>::construct(
+    int rule,
+    const std::string &text,
+    std::index_sequence<I...> /*indices*/) -> std::unique_ptr<Token>
+{
+    using RuleTuple = std::tuple<Rules...>;
+    std::unique_ptr<Token> token;
+    (void)((rule == static_cast<int>(I)
+                ? ([&] {
+                       using SubToken =
+                           typename std::tuple_element_t<I,
+                                                         RuleTuple>::TokenType;
+                       if constexpr (!std::is_void_v<SubToken>) {
+                           token = makeToken<Token, SubToken>(text, ids[I]);
+                       }
+                   }(),
+                   true)
+                : false)
+           || ...);
+    return token;
+}
+
+template<typename Token, typename... Rules>
+auto lexer::StaticLexer<Token, Rules...>::runLength(std::string_view text,
+                                                   std::size_t pos) const
+    -> std::size_t
+{
+    if (soleActive < 0) {
+        return 0;
+    }
+    const ByteScanner *scanner =
+        tables[soleActive]->selfLoop(states[soleActive]);
+    if (scanner == nullptr) {
+        return 0;
+    }
+    const char *begin = text.data() + pos;
+    return static_cast<std::size_t>(
+        scanner->skip(begin, text.data() + text.size()) - begin);
+}
+
+template<typename Token, typename... Rules>
+auto lexer::StaticLexer<Token, Rules...>::stateKey() -> std::string_view
+{
+    key.clear();
+    for (std::size_t i = 0; i < ruleCount; i++) {
+        if (states[i] == (int)State::Accept || states[i] == (int)State::Reject) {
+            continue;
+        }
+        char bytes[sizeof(std::size_t) + sizeof(int)];
+        std::memcpy(bytes, &i, sizeof(std::size_t));
+        std::memcpy(bytes + sizeof(std::size_t), &states[i], sizeof(int));
+        key.append(bytes, sizeof(bytes));
+    }
+    return key;
+}
+
+template<typename Token, typename... Rules>
+void lexer::StaticLexer<Token, Rules...>::reset()
+{
+    states.fill((int)State::Enter);
+}
+
+// The same scan as LexSession::stepLane. With is set, text is instead the
+// bytes read from it since the start of the current token: more are read in
+// chunks whenever the scan runs out, and those of emitted tokens are dropped
+// along with what the memo knew about them, as LexSession::push does.
+template<typename Token, typename... Rules>
+auto lexer::StaticLexer<Token, Rules...>::run(std::string_view text,
+                                             std::istream *is)
+    -> std::vector<std::unique_ptr<Token>>
+{
+    std::vector<std::unique_ptr<Token>> tokens;
+    text = text.substr(0, text.find('\0'));
+    reset();
+    memo.clear();
+
+    std::size_t base = 0; // offset of text in the whole input
+    Location origin;      // location of the start of text
+    std::size_t pos = 0;
+    std::size_t start = 0;
+    int lastRule = -1; // the longest token seen since start
+    std::size_t lastEnd = 0;
+    bool more = is != nullptr;
+    auto refill = [&] {
+        origin.advance(text.substr(0, start));
+        held.erase(0, start);
+        base += start;
+        pos -= start;
+        lastEnd -= std::min(lastEnd, start);
+        start = 0;
+        if (!memo.empty()) {
+            memo.forget(base);
+        }
+        std::size_t size = held.size();
+        held.resize(size + streamChunk);
+        is->read(held.data() + size, static_cast<std::streamsize>(streamChunk));
+        held.resize(size + static_cast<std::size_t>(is->gcount()));
+        std::size_t end = held.find('\0', size);
+        if (end != std::string::npos) {
+            held.resize(end);
+        }
+        more = *is && end == std::string::npos;
+        text = held;
+    };
+    auto markAccept = [&](int rule, std::size_t end) {
+        lastRule = rule;
+        lastEnd = end;
+        memo.accept();
+    };
+    auto emit = [&](int rule, std::size_t end) {
+        currToken.assign(text.substr(start, end - start));
+        std::unique_ptr<Token> token = construct(rule, currToken, Indices{});
+        if (token != nullptr) {
+            tokens.push_back(std::move(token));
+        }
+        reset();
+        start = end;
+        pos = end;
+        lastRule = -1;
+    };
+
+    held.clear();
+    while (text.empty() && more) {
+        refill();
+    }
+    if (text.empty()) {
+        loc = Location();
+        return tokens;
+    }
+    while (true) {
+        while (pos == text.size() && more) {
+            refill();
+        }
+        int c = pos < text.size() ? static_cast<unsigned char>(text[pos]) : EOF;
+        auto [stillMatching, firstAccepted, firstFinal] =
+            transitionStates(static_cast<char>(c), Indices{});
+
+        if (!stillMatching && firstAccepted >= 0) {
+            emit(firstAccepted, pos);
+            if (c == EOF) {
+                break;
+            }
+            continue;
+        }
+        if (stillMatching && c != EOF) {
+            if (firstAccepted >= 0 && pos > start) {
+                markAccept(firstAccepted, pos);
+            }
+            pos++;
+            if (firstFinal >= 0) {
+                markAccept(firstFinal, pos);
+            }
+            bool lookingAhead = lastRule >= 0 && lastEnd < pos;
+            std::string_view k;
+            std::size_t limit = text.size();
+            if (lookingAhead) {
+                k = stateKey();
+                if (!memo.empty()) {
+                    std::size_t deadAt = memo.deadFrom(k, base + pos);
+                    limit = std::min(limit, deadAt - base);
+                }
+            }
+            std::size_t n = runLength(text.substr(0, limit), pos);
+            bool dead = limit < text.size() && pos + n == limit;
+            if (lookingAhead) {
+                memo.visit(k, base + pos, base + pos + n);
+            }
+            if (!dead) {
+                pos += n;
+                if (n > 0 && firstFinal >= 0) {
+                    markAccept(firstFinal, pos);
+                }
+                continue;
+            }
+        }
+
+        // Every machine died, or the input ended part way through a token.
+        if (lastRule < 0) {
+            loc = origin;
+            loc.advance(text.substr(0, pos));
+            if (stillMatching) {
+                throw LexException(loc.line, loc.col, "Unexpected EOF");
+            }
+            if (c != EOF) {
+                loc.advance(c);
+            }
+            throw LexException::unexpected(loc.line, loc.col, c);
+        }
+        memo.fail();
+        emit(lastRule, lastEnd);
+        if (pos == text.size() && !more) {
+            break;
+        }
+    }
+
+    loc = origin;
+    loc.advance(text);
+    return tokens;
+}
+
+// vim:ft=cpp
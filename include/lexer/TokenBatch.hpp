@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace lexer {
+
+// The tokens of many records in one flat array. The tokens of record i are
+// tokens[offsets[i]] up to, but not including, tokens[offsets[i + 1]].
+// Passing the same batch to LexSession::tokenizeBatch again reuses its
+// buffers.
+template<typename Token>
+struct TokenBatch {
+    std::vector<std::unique_ptr<Token>> tokens;
+    std::vector<std::size_t> offsets;
+
+    auto size() const -> std::size_t
+    {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+    auto count(std::size_t record) const -> std::size_t
+    {
+        return offsets[record + 1] - offsets[record];
+    }
+    auto token(std::size_t record, std::size_t i) const -> const Token &
+    {
+        return *tokens[offsets[record] + i];
+    }
+};
+
+} // namespace lexer
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lexer {
+
+// Where a token lies in its source and which rule produced it. Rule indices
+// are dense, so they double as the token's type id within one lexer.
+struct TokenSpan {
+    static constexpr std::size_t unknown = -1;
+
+    unsigned rule = 0;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    // One past the furthest byte read while lexing the tokens before this
+    // one, which may lie past begin when lexing had to look ahead. relex
+    // uses it to tell which spans an edit may change. It is not cached, so
+    // spans read back from a cache leave it unknown.
+    std::size_t reach = unknown;
+};
+
+// 64-bit FNV-1a, used to tie a cached token stream to its source and lexer.
+auto contentHash(std::string_view data,
+                 std::uint64_t seed = 0xcbf29ce484222325) -> std::uint64_t;
+
+// The on-disk form of a token stream: a header holding a magic number, the
+// source and lexer hashes and the span count, then three varints per span,
+// namely the gap since the end of the previous span, the length and the
+// rule. Tokens are usually adjacent and short, so most spans take 3 bytes.
+auto encodeSpans(const std::vector<TokenSpan> &spans,
+                 std::uint64_t sourceHash,
+                 std::uint64_t lexerHash) -> std::string;
+
+// Decodes spans straight out of an encoded stream, e.g. a mapped file, without
+// copying it. data must outlive the reader.
+class SpanReader {
+  public:
+    SpanReader(std::string_view data);
+
+    // Whether data holds a complete header. Truncated spans are caught by
+    // next.
+    auto valid() const -> bool { return ok; }
+    auto sourceHash() const -> std::uint64_t { return source; }
+    auto lexerHash() const -> std::uint64_t { return lexer; }
+    auto size() const -> std::size_t { return count; }
+
+    // Reads the next span. Returns false at the end of the stream or if the
+    // stream is corrupt.
+    auto next(TokenSpan &span) -> bool;
+
+  private:
+    auto varint(std::uint64_t &value) -> bool;
+
+    std::string_view data;
+    std::size_t pos = 0;
+    std::size_t read = 0; // spans read so far
+    std::size_t lastEnd = 0;
+    std::uint64_t source = 0;
+    std::uint64_t lexer = 0;
+    std::size_t count = 0;
+    bool ok = false;
+};
+
+} // namespace lexer
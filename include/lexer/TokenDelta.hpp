@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "lexer/TokenCache.hpp"
+
+namespace lexer {
+
+// A change to a text: removed bytes at offset were replaced by inserted new
+// ones.
+struct Edit {
+    std::size_t offset = 0;
+    std::size_t removed = 0;
+    std::size_t inserted = 0;
+};
+
+// How the spans of a text change under an Edit. Old spans [first, first +
+// removed) are replaced by inserted, which hold offsets into the new text.
+// The old spans after them are unchanged apart from moving by shift bytes.
+struct TokenDelta {
+    std::size_t first = 0;
+    std::size_t removed = 0;
+    std::vector<TokenSpan> inserted;
+    long shift = 0;
+
+    // Applies the delta to the spans it was computed from. Only the spans
+    // after the edit are touched, and only to move their offsets.
+    void apply(std::vector<TokenSpan> &spans) const;
+};
+
+} // namespace lexer
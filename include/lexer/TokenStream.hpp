@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+#include "lexer/CompiledLexer.hpp"
+#include "lexer/TokenCache.hpp"
+
+namespace lexer {
+
+// Tokens read back from a stream written by CompiledLexer::cache, so an
+// unchanged source need not be lexed again. Spans are decoded one at a time
+// and a token is only constructed, from its text in source, when next() asks
+// for it. The lexer, source and data must outlive the stream.
+template<typename Token>
+class TokenStream {
+  public:
+    TokenStream(const CompiledLexer<Token> &lexer,
+                std::string_view source,
+                std::string_view data);
+
+    // Whether data was written for source by a lexer with the same rules,
+    // and no span read so far was corrupt or cut short. An invalid stream
+    // yields nothing more; lex the source instead.
+    auto valid() const -> bool { return matches; }
+    // The number of spans, counting any whose token comes out as nullptr.
+    auto size() const -> std::size_t { return reader.size(); }
+
+    // The next span, without constructing its token.
+    auto next(TokenSpan &span) -> bool;
+    // The next token, or nullptr at the end of the stream.
+    auto next() -> std::unique_ptr<Token>;
+    auto text(const TokenSpan &span) const -> std::string_view
+    {
+        return source.substr(span.begin, span.end - span.begin);
+    }
+
+  private:
+    const CompiledLexer<Token> &lexer;
+    std::string_view source;
+    SpanReader reader;
+    bool matches = false;
+};
+
+} // namespace lexer
+
+#include "lexer/TokenStream.tpp" // IWYU pragma: keep
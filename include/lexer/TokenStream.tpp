@@ -0,0 +1,54 @@
+#pragma once
+
+#include "lexer/TokenStream.hpp"
+
+#include <memory>
+#include <string_view>
+
+#include "lexer/CompiledLexer.hpp"
+#include "lexer/TokenCache.hpp"
+
+template<typename Token>
+lexer::TokenStream<Token>::TokenStream(const CompiledLexer<Token> &lexer,
+                                       std::string_view source,
+                                       std::string_view data)
+    : lexer(lexer), source(source), reader(data)
+{
+    matches = reader.valid() && reader.lexerHash() == lexer.fingerprint()
+              && reader.sourceHash() == contentHash(source);
+}
+
+template<typename Token>
+auto lexer::TokenStream<Token>::next(TokenSpan &span) -> bool
+{
+    if (!matches) {
+        return false;
+    }
+    if (!reader.next(span)) {
+        matches = reader.valid(); // false if the spans were cut short
+        return false;
+    }
+    // A corrupt stream could point outside the source or at a rule that
+    // does not exist.
+    if (span.end > source.size() || span.rule >= lexer.rules().size()) {
+        matches = false;
+        return false;
+    }
+    return true;
+}
+
+template<typename Token>
+auto lexer::TokenStream<Token>::next() -> std::unique_ptr<Token>
+{
+    TokenSpan span;
+    while (next(span)) {
+        std::unique_ptr<Token> token =
+            lexer.construct(span.rule, source, span.begin, span.end);
+        if (token != nullptr) {
+            return token;
+        }
+    }
+    return nullptr;
+}
+
+// vim:ft=cpp
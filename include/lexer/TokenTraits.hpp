@@ -0,0 +1,106 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "lexer/Captures.hpp"
+#include "lexer/Payload.hpp"
+
+namespace lexer {
+
+// A Token type has type ids if it provides a registry `Token::id<T>()` and a
+// `setId` member, like parser::Token. The lexer then registers every token
+// type when its rule is added and stamps the id into each constructed token.
+template<typename Token, typename SubToken, typename = void>
+struct HasTokenIds : std::false_type {};
+
+template<typename Token, typename SubToken>
+struct HasTokenIds<
+    Token,
+    SubToken,
+    std::void_t<decltype(Token::template id<SubToken>()),
+                decltype(std::declval<Token &>().setId(
+                    Token::template id<SubToken>()))>> : std::true_type {};
+
+template<typename Token, typename SubToken>
+inline constexpr bool hasTokenIds =
+    !std::is_void_v<SubToken> && HasTokenIds<Token, SubToken>::value;
+
+// Whether SubToken's id() is still Token's own, rather than one it declares
+// itself and that the stamped id would never reach.
+template<typename Token, typename SubToken, typename = void>
+struct KeepsTokenId : std::false_type {};
+
+template<typename Token, typename SubToken>
+struct KeepsTokenId<
+    Token,
+    SubToken,
+    std::void_t<decltype(static_cast<decltype(Token::template id<SubToken>()) (
+                             Token::*)() const>(&SubToken::id))>>
+    : std::bool_constant<
+          static_cast<decltype(Token::template id<SubToken>()) (Token::*)()
+                          const>(&SubToken::id)
+          == static_cast<decltype(Token::template id<SubToken>()) (Token::*)()
+                             const>(&Token::id)> {};
+
+// Returns the id registered for SubToken, or 0 if Token has no type ids.
+template<typename Token, typename SubToken>
+auto registerTokenType() -> int
+{
+    if constexpr (hasTokenIds<Token, SubToken>) {
+        static_assert(KeepsTokenId<Token, SubToken>::value,
+                      "token types no longer override id(): pass "
+                      "Token::id<T>() to the constructor instead");
+        return Token::template id<SubToken>();
+    } else {
+        return 0;
+    }
+}
+
+// A SubToken that can be constructed from its text and Captures gets the
+// submatch offsets of its rule's capture groups.
+template<typename SubToken>
+inline constexpr bool takesCaptures =
+    std::is_constructible_v<SubToken, const std::string &, const Captures &>;
+
+// A SubToken that can be constructed from a Payload can be given the decoded
+// value of its token instead of the text.
+template<typename SubToken>
+inline constexpr bool takesPayload =
+    std::is_constructible_v<SubToken, const Payload &>;
+
+template<typename Token, typename SubToken>
+auto makeToken(const Payload &payload, int id) -> std::unique_ptr<Token>
+{
+    auto token = std::make_unique<SubToken>(payload);
+    if constexpr (hasTokenIds<Token, SubToken>) {
+        token->setId(id);
+    }
+    return token;
+}
+
+template<typename Token, typename SubToken>
+auto makeToken(const std::string &text,
+               const Captures &captures,
+               int id) -> std::unique_ptr<Token>
+{
+    auto token = std::make_unique<SubToken>(text, captures);
+    if constexpr (hasTokenIds<Token, SubToken>) {
+        token->setId(id);
+    }
+    return token;
+}
+
+template<typename Token, typename SubToken>
+auto makeToken(const std::string &text, int id) -> std::unique_ptr<Token>
+{
+    auto token = std::make_unique<SubToken>(text);
+    if constexpr (hasTokenIds<Token, SubToken>) {
+        token->setId(id);
+    }
+    return token;
+}
+
+} // namespace lexer
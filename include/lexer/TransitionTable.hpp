@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "lexer/ByteScanner.hpp"
+#include "lexer/StateMachine.hpp"
+
+namespace lexer {
+
+// A StateMachine flattened into a dense next-state table. Bytes that behave
+// the same in every state share a column, so a step is two array loads.
+class TransitionTable {
+  public:
+    TransitionTable(const StateMachine &sm);
+
+    auto transition(int state, char c) const -> int
+    {
+        return next[state * classCount
+                    + byteClass[static_cast<unsigned char>(c)]];
+    }
+    // Returns a scanner over the bytes that keep the machine in state, or
+    // nullptr if no byte loops back to it.
+    auto selfLoop(int state) const -> const ByteScanner *
+    {
+        int k = loopScanner[state];
+        return k < 0 ? nullptr : &scanners[k];
+    }
+    // The capture tags to record when stepping from state on c. Always empty
+    // for a machine built without capture groups.
+    auto tags(int state, char c) const -> const std::vector<unsigned> &
+    {
+        if (tagList.empty()) {
+            return tagLists[0];
+        }
+        return tagLists[tagList[state * classCount
+                                + byteClass[static_cast<unsigned char>(c)]]];
+    }
+    // Whether a token may end in state, i.e. the machine accepts the bytes
+    // that led to it.
+    auto final(int state) const -> bool { return finals[state] != 0; }
+    auto tagged() const -> bool { return !tagList.empty(); }
+    // One more than the highest tag slot, so 2 * (groups + 1) when the
+    // last group is recorded.
+    auto slotCount() const -> unsigned { return slots; }
+    auto size() const -> unsigned { return stateCount; }
+
+    // Returns a copy whose state k is the state originally numbered order[k],
+    // so that a profile can pack the hottest rows together. order must keep
+    // Enter, Accept and Reject in place.
+    auto reordered(const std::vector<int> &order) const -> TransitionTable;
+    // Whether order is a permutation of the states that reordered accepts.
+    auto validOrder(const std::vector<int> &order) const -> bool;
+    // The original number of each state; the identity unless reordered.
+    auto order() const -> const std::vector<int> & { return original; }
+    auto classes() const -> unsigned { return classCount; }
+
+  private:
+    std::array<unsigned char, 256> byteClass{};
+    std::vector<int> next;
+    std::vector<int> tagList; // index into tagLists, parallel to next
+    std::vector<std::vector<unsigned>> tagLists;
+    unsigned slots = 0;
+    std::vector<char> finals;
+    std::vector<int> original;
+    std::vector<int> loopScanner; // index into scanners, or -1
+    std::vector<ByteScanner> scanners;
+    unsigned stateCount;
+    unsigned classCount = 0;
+};
+
+} // namespace lexer
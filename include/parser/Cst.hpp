@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "parser/Token.hpp"
+
+namespace parser {
+
+class Production;
+
+// A concrete syntax tree kept in one array of 16-byte nodes, children before
+// their parents, so that walking the array in order visits every node after
+// its subtree and freeing the nodes is one deallocation. Unlike
+// Production::Node it keeps a node for every production matched, empty ones
+// included, and the tokens are held in their own array in input order. The
+// tokens are still the lexer's own allocations, so freeing the tree also
+// deletes each token on its own.
+class Cst {
+  public:
+    static constexpr std::uint32_t none = -1;
+
+    enum class Kind : std::uint8_t { Terminal, NonTerminal };
+
+    struct Node {
+        Kind kind;
+        std::uint32_t production; // an index into productions(), or none
+        std::uint32_t first;      // the first child, or a terminal's token
+        std::uint32_t next;       // the next sibling
+    };
+
+    class ChildIterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::uint32_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::uint32_t *;
+        using reference = std::uint32_t;
+
+        ChildIterator(const Node *nodes, std::uint32_t node)
+            : nodes(nodes), node(node)
+        {}
+        auto operator*() const -> std::uint32_t { return node; }
+        auto operator++() -> ChildIterator &
+        {
+            node = nodes[node].next;
+            return *this;
+        }
+        auto operator==(const ChildIterator &o) const -> bool
+        {
+            return node == o.node;
+        }
+        auto operator!=(const ChildIterator &o) const -> bool
+        {
+            return node != o.node;
+        }
+
+      private:
+        const Node *nodes;
+        std::uint32_t node;
+    };
+
+    struct Children {
+        ChildIterator first;
+        auto begin() const -> ChildIterator { return first; }
+        auto end() const -> ChildIterator { return {nullptr, none}; }
+    };
+
+    auto nodes() const -> const std::vector<Node> & { return nodeList; }
+    auto tokens() const -> const std::vector<std::unique_ptr<Token>> &
+    {
+        return tokenList;
+    }
+    auto productions() const -> const std::vector<const Production *> &
+    {
+        return prods;
+    }
+    // The last node, or none for a tree with no nodes.
+    auto root() const -> std::uint32_t
+    {
+        return static_cast<std::uint32_t>(nodeList.size() - 1);
+    }
+    auto children(std::uint32_t node) const -> Children
+    {
+        const Node &n = nodeList[node];
+        return {{nodeList.data(),
+                 n.kind == Kind::NonTerminal ? n.first : none}};
+    }
+    auto token(std::uint32_t node) const -> const Token &
+    {
+        return *tokenList[nodeList[node].first];
+    }
+    auto production(std::uint32_t node) const -> const Production &
+    {
+        return *prods[nodeList[node].production];
+    }
+
+    // Builds the tree bottom up: each node is added after its children,
+    // which become the children of no other node.
+    auto terminal(std::unique_ptr<Token> token) -> std::uint32_t;
+    auto nonTerminal(const Production &p,
+                     const std::uint32_t *children,
+                     std::size_t count) -> std::uint32_t;
+
+  private:
+    std::vector<Node> nodeList;
+    std::vector<std::unique_ptr<Token>> tokenList;
+    std::vector<const Production *> prods;
+    std::unordered_map<const Production *, std::uint32_t> prodIndex;
+};
+
+// Prints like a Production::Node, with each nonterminal named by its
+// production.
+auto operator<<(std::ostream &os, const Cst &cst) -> std::ostream &;
+
+} // namespace parser
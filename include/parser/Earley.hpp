@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "parser/Forest.hpp"
+#include "parser/Production.hpp"
+#include "parser/Token.hpp"
+
+namespace parser {
+
+// An Earley parser for any Production grammar, ambiguous, left-recursive or
+// with empty rules, that returns every parse as a Forest. It runs in cubic
+// time at worst, and in linear time on LR(k) grammars: Leo's optimization
+// keeps right recursion from leaving a completed item per level behind in
+// every set.
+class Earley {
+  public:
+    Earley(const Production &goal);
+
+    auto parse(const std::vector<std::unique_ptr<Token>> &tokens) -> Forest;
+
+    // Items in the sets of the last parse.
+    std::size_t itemCount = 0;
+
+  private:
+    static constexpr std::uint32_t none = -1;
+
+    struct Rule {
+        std::size_t lhs;
+        const std::vector<Production::Symbol> *symbols;
+        std::vector<std::uint32_t> productions; // by symbol, or none
+    };
+
+    // A rule with its first dot symbols matched from origin up to set.
+    struct Item {
+        std::uint32_t rule;
+        std::uint32_t dot;
+        std::uint32_t origin;
+        std::uint32_t set;
+        std::uint32_t link = none; // the first of its links
+        // The next item waiting on the same production in the set, or for a
+        // complete item, the next one with the same production and origin.
+        std::uint32_t next = none;
+    };
+
+    // One way an item came about: from pred, by matching the symbol before
+    // the item's dot from pred's set to the item's. A Leo link instead
+    // names a Leo entry, standing for the chain of items it skipped.
+    struct Link {
+        std::uint32_t pred;
+        std::uint32_t next;
+        bool leo;
+    };
+
+    // The one item of a set waiting on a production as its last symbol,
+    // and the entry for that item's own production in its origin's set.
+    // Completing the production goes straight to completing top.
+    struct Leo {
+        std::uint32_t pred;
+        std::uint32_t next;
+        std::uint32_t top; // the pred of the last entry of the chain
+    };
+
+    struct Key {
+        std::uint32_t a, b, c, d;
+        auto operator==(const Key &k) const -> bool
+        {
+            return a == k.a && b == k.b && c == k.c && d == k.d;
+        }
+    };
+    struct KeyHash {
+        auto operator()(const Key &k) const -> std::size_t
+        {
+            std::uint64_t h = k.a;
+            h = h * 0x9e3779b97f4a7c15 + k.b;
+            h = h * 0x9e3779b97f4a7c15 + k.c;
+            h = h * 0x9e3779b97f4a7c15 + k.d;
+            return static_cast<std::size_t>(h ^ (h >> 29));
+        }
+    };
+
+    std::vector<const Production *> prods;
+    std::vector<bool> nullable;
+    std::vector<Rule> rules;
+    std::vector<std::uint32_t> ruleBegin; // by production, plus one
+
+    std::vector<Item> items;
+    std::vector<Link> links;
+    std::vector<Leo> leos;
+    std::unordered_map<Key, std::uint32_t, KeyHash> itemIndex;
+    // Heads of the lists of items waiting on a production in a set, and of
+    // complete items by set, production and origin.
+    std::unordered_map<Key, std::uint32_t, KeyHash> waiting;
+    std::unordered_map<Key, std::uint32_t, KeyHash> complete;
+    std::unordered_map<Key, std::uint32_t, KeyHash> leoIndex;
+    std::unordered_set<std::uint64_t> linked;
+    std::vector<std::uint32_t> predicted; // by production, the set plus one
+
+    auto add(std::uint32_t set,
+             std::uint32_t rule,
+             std::uint32_t dot,
+             std::uint32_t origin) -> std::uint32_t;
+    void link(std::uint32_t item, std::uint32_t pred, bool leo = false);
+    void process(std::uint32_t set, std::uint32_t item);
+    auto leo(std::uint32_t set, std::uint32_t production) -> std::uint32_t;
+    template<typename Visit>
+    void expand(std::uint32_t item, std::uint32_t leo, Visit visit);
+    auto forest(std::uint32_t end) -> Forest;
+    static auto matches(const Production::Symbol &s, const Token &token)
+        -> bool;
+};
+
+} // namespace parser
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "parser/Production.hpp"
+#include "parser/Token.hpp"
+
+namespace parser {
+
+class Earley;
+
+// A shared packed parse forest: every parse of the input at once, with the
+// parts the parses have in common stored once, so that even exponentially
+// many parses take polynomial space.
+//
+// A symbol node is a production or token matched over the tokens
+// [start, end). Its alternatives are item nodes, one per rule of the
+// production that matches there. An item node is the first dot symbols of
+// a rule matched over [start, end), and each of its packed nodes is one way
+// to split that: an item node for all but the last symbol, then a symbol
+// node for the last. Symbol 0 is the whole input matching the goal.
+class Forest {
+  public:
+    static constexpr std::size_t none = -1;
+
+    struct Symbol {
+        const Production *production; // nullptr for a token
+        std::size_t start;
+        std::size_t end;
+        std::size_t first; // alternatives are choices [first, first + count)
+        std::size_t count;
+    };
+    struct Item {
+        const Production *production;
+        std::size_t rule;
+        std::size_t dot;
+        std::size_t start;
+        std::size_t end;
+        std::size_t first; // packed nodes [first, first + count)
+        std::size_t count; // 0 for an empty rule
+    };
+    struct Packed {
+        std::size_t left;  // an item, or none when dot is 1
+        std::size_t right; // a symbol
+    };
+
+    auto symbols() const -> const std::vector<Symbol> & { return symbolNodes; }
+    auto items() const -> const std::vector<Item> & { return itemNodes; }
+    auto packed() const -> const std::vector<Packed> & { return packedNodes; }
+    auto choice(const Symbol &s, std::size_t k) const -> std::size_t
+    {
+        return choices[s.first + k];
+    }
+
+    // Whether any node has more than one alternative.
+    auto ambiguous() const -> bool;
+    // The number of parses, saturating at the largest unsigned long. Infinite
+    // when a production can derive itself, as with A -> A.
+    auto treeCount() const -> unsigned long;
+    // One of the parses, as produce would build it. The tokens of the tree
+    // are taken out of tokens, which must be the input that was parsed.
+    auto tree(std::vector<std::unique_ptr<Token>> &tokens) const
+        -> Production::Node;
+
+  private:
+    friend class Earley;
+
+    std::vector<Symbol> symbolNodes;
+    std::vector<Item> itemNodes;
+    std::vector<Packed> packedNodes;
+    std::vector<std::size_t> choices;
+
+    // Nodes are numbered symbols, then items, then packed nodes.
+    auto nodeCount() const -> std::size_t;
+    template<typename F>
+    void eachChild(std::size_t node, F f) const;
+    auto order(bool any, std::vector<std::size_t> *chosen) const
+        -> std::vector<std::size_t>;
+};
+
+} // namespace parser
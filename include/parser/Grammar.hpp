@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "parser/Production.hpp"
+
+namespace parser {
+
+class ParseTable;
+
+// The nullable, FIRST and FOLLOW sets of every production reachable from a
+// goal, and the LL(1) table produce chooses rules from. A goal builds its
+// Grammar once, on first use, and it is only read after that, so any number
+// of threads can parse from the same goal. Rules added afterwards to any of
+// its productions are not seen.
+class Grammar {
+  public:
+    using Symbol = Production::Symbol;
+    using SymbolSet = std::unordered_set<Symbol>;
+
+    static constexpr std::size_t none = -1;
+
+    Grammar(const Production &goal);
+
+    // The productions reachable from the goal, which is row 0.
+    auto rows() const -> const std::vector<const Production *> &
+    {
+        return prods;
+    }
+    // The row of p, or none if it cannot be reached from the goal.
+    auto row(const Production &p) const -> std::size_t;
+    // The row of the production at symbol k of rule r of row, or none for a
+    // terminal.
+    auto symbolRow(std::size_t row, std::size_t r, std::size_t k) const
+        -> std::size_t
+    {
+        return symbolRows[ruleBegin[row] + r][k];
+    }
+
+    auto nullable(std::size_t row) const -> bool { return sets[row].nullable; }
+    auto first(std::size_t row) const -> const SymbolSet &
+    {
+        return sets[row].first;
+    }
+    auto follow(std::size_t row) const -> const SymbolSet &
+    {
+        return sets[row].follow;
+    }
+    // Whether the input may end after the production.
+    auto canEnd(std::size_t row) const -> bool { return sets[row].canEnd; }
+    auto ruleFirst(std::size_t row, std::size_t r) const -> const SymbolSet &
+    {
+        return sets[row].ruleFirst.at(r);
+    }
+    auto ruleNullable(std::size_t row, std::size_t r) const -> bool
+    {
+        return sets[row].ruleNullable.at(r);
+    }
+    // Conflicts are resolved in favour of the earlier rule.
+    auto table() const -> const ParseTable & { return *ll1; }
+
+  private:
+    struct Sets {
+        bool nullable = false;
+        bool canEnd = false;
+        SymbolSet first;
+        SymbolSet follow;
+        std::vector<SymbolSet> ruleFirst;
+        std::vector<bool> ruleNullable;
+    };
+
+    std::vector<const Production *> prods;
+    std::unordered_map<const Production *, std::size_t> rowOf;
+    std::vector<Sets> sets;
+    std::vector<std::size_t> ruleBegin;               // by row
+    std::vector<std::vector<std::size_t>> symbolRows; // by rule
+    std::shared_ptr<const ParseTable> ll1;
+
+    auto addFirst(std::vector<Symbol>::const_iterator begin,
+                  std::vector<Symbol>::const_iterator end,
+                  SymbolSet &set) const -> bool;
+};
+
+} // namespace parser
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "parser/ParseContext.hpp"
+#include "parser/Production.hpp"
+#include "parser/Token.hpp"
+
+namespace parser {
+
+// LALR(1) tables for the grammar of a goal Production, and a shift-reduce
+// parser that runs them. Unlike produce it takes left-recursive grammars and
+// never recurses. It builds the same trees: a rule's node is its only child
+// or a NonTerminal of its children, leaving out empty productions.
+class LRTable {
+  public:
+    using Symbol = Production::Symbol;
+    using Node = Production::Node;
+
+    // Two actions for the same state and lookahead. Shifts win over
+    // reductions, and earlier rules over later ones.
+    struct Conflict {
+        std::size_t state;
+        std::optional<Symbol> lookahead; // nullopt for the end of input
+        const Production *production;    // the reduction dropped
+        std::size_t rule;
+        bool shift; // whether it lost to a shift rather than a reduction
+    };
+
+    LRTable(const Production &goal);
+
+    auto parse(std::vector<std::unique_ptr<Token>> &tokens) const -> Node;
+    auto parse(ParseContext &ctx) const -> Node;
+    auto conflicts() const -> const std::vector<Conflict> & { return found; }
+    auto stateCount() const -> std::size_t { return actionRow.size(); }
+    // The action rows stored. States with the same actions share a row, and
+    // states that can only reduce by one rule keep none.
+    auto rowCount() const -> std::size_t
+    {
+        return actions.size() / columnCount;
+    }
+
+  private:
+    struct Rule {
+        std::size_t lhs;
+        std::size_t length;
+        const Production *production; // nullptr for the accepting rule
+        std::size_t index;            // in production
+    };
+
+    // An action is a shift to state s as s + 1, a reduction by rule r as
+    // -(r + 1), or 0 for an error.
+    std::size_t columnCount = 1; // column 0 is the end of input
+    std::vector<int> idColumn;   // by Token::Id, -1 if not a terminal
+    std::unordered_map<std::string, std::size_t> textColumn;
+    std::vector<Symbol> columnSymbol; // column 0 holds a placeholder
+    std::vector<int> actions;
+    std::vector<std::size_t> actionRow;
+    std::vector<int> defaultAction; // taken without reading the token
+    std::size_t nonTerminalCount = 0;
+    std::vector<std::size_t> gotos;
+    std::vector<std::size_t> gotoRow;
+    std::vector<Rule> rules;
+    std::vector<Conflict> found;
+
+    auto column(const Symbol &s) -> std::size_t;
+    auto action(std::size_t state, const Token *token) const -> int;
+    void fail(const ParseContext &ctx, std::size_t state) const;
+};
+
+auto operator<<(std::ostream &os,
+                const LRTable::Conflict &c) -> std::ostream &;
+
+} // namespace parser
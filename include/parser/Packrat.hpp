@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "parser/Production.hpp"
+#include "parser/Token.hpp"
+
+namespace parser {
+
+// Ordered-choice parsing for grammars that are not LL(1). A production tries
+// its rules in order and takes the first that matches, backtracking over the
+// tokens when a rule fails part way; empty rules always match. Results are
+// memoized by (production, token index), so each is worked out once and
+// parsing stays linear while the memo holds them. Left recursion does not
+// match. The trees are those produce builds.
+class Packrat {
+  public:
+    using Node = Production::Node;
+
+    // The memo keeps at most memoSize results, rounded up to a power of two,
+    // 16 bytes each. A result whose slot is needed again is evicted and
+    // worked out again if asked for. Besides the memo, each match of a
+    // production takes 12 bytes until the parse ends.
+    Packrat(const Production &goal, std::size_t memoSize = 1 << 16);
+
+    // Parses the whole of tokens, taking the tokens of the tree out of it.
+    auto parse(std::vector<std::unique_ptr<Token>> &tokens) -> Node;
+
+    // Results found in and evicted from the memo by the last parse.
+    unsigned long hits = 0;
+    unsigned long evictions = 0;
+
+  private:
+    static constexpr std::uint32_t none = -1;
+
+    // A result: how production matched at pos, if it did.
+    struct Entry {
+        std::uint32_t production = none;
+        std::uint32_t pos = 0;
+        std::uint32_t end = 0;     // one past the last token matched
+        std::uint32_t step = none; // the match in steps, none if it failed
+    };
+
+    // A production that matched, kept until the end of the parse to build
+    // the tree from. The steps of its rule's productions, in order, start
+    // at kids in the list of the same name.
+    struct Step {
+        std::uint32_t production;
+        std::uint32_t rule;
+        std::uint32_t kids;
+    };
+
+    struct Frame {
+        std::size_t production;
+        std::size_t start;
+        std::size_t rule;
+        std::size_t symbol;
+        std::size_t pos;
+        std::size_t kids; // where the rule's matched kids start in pending
+    };
+
+    std::vector<const Production *> prods;
+    std::unordered_map<const Production *, std::size_t> index;
+    std::vector<Entry> memo;
+    std::vector<Step> steps;
+    std::vector<std::uint32_t> kids;
+    std::vector<std::uint32_t> pending; // kids of the rules being tried
+    std::vector<Frame> frames;
+    // Where each production is being matched, innermost last. The starts
+    // never decrease going in, so checking the last finds left recursion.
+    std::vector<std::vector<std::size_t>> active;
+    const std::vector<std::unique_ptr<Token>> *tokens = nullptr;
+    std::size_t furthest = 0; // the furthest token a terminal failed at
+
+    auto match(std::size_t production, std::size_t pos) -> Entry;
+    auto find(std::size_t production, std::size_t pos) -> const Entry *;
+    void store(const Entry &e);
+    auto matches(const Production::Symbol &s, std::size_t pos) -> bool;
+    auto build(std::vector<std::unique_ptr<Token>> &input,
+               std::uint32_t step,
+               std::size_t pos) -> Node;
+};
+
+} // namespace parser
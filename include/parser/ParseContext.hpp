@@ -1,7 +1,9 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "parser/Token.hpp"
@@ -13,18 +15,30 @@ class ParseContext {
     std::unique_ptr<Token> token;
     unsigned i;
 
-    ParseContext(std::vector<std::unique_ptr<Token>> &tokens) : tokens(tokens)
+    ParseContext(std::vector<std::unique_ptr<Token>> &tokens)
+        : tokens(&tokens)
     {
         i = 0;
         token = nextToken();
     }
+    // Pulls tokens from source as the parse needs them, e.g. from a cached
+    // lexer::TokenStream. source returns nullptr at the end of the input.
+    ParseContext(std::function<std::unique_ptr<Token>()> source)
+        : source(std::move(source))
+    {
+        i = 0;
+        token = nextToken();
+    }
+    // Takes the current token, whatever it is; only the end of input fails.
+    auto eat() -> std::unique_ptr<Token>;
     auto eat(Token::Id t) -> std::unique_ptr<Token>;
     auto eat(char c) -> std::unique_ptr<Token>;
     auto eat(const std::string &s) -> std::unique_ptr<Token>;
     void error(const std::string &msg = "") const;
 
   private:
-    std::vector<std::unique_ptr<Token>> &tokens;
+    std::vector<std::unique_ptr<Token>> *tokens = nullptr;
+    std::function<std::unique_ptr<Token>()> source;
     auto eatGeneric(bool tokenIsValid, const std::string &expectedToken = "")
         -> std::unique_ptr<Token>;
     auto nextToken() -> std::unique_ptr<Token>;
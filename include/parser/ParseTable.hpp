@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "parser/Production.hpp"
+#include "parser/Token.hpp"
+
+namespace parser {
+
+class Grammar;
+
+// An LL(1) table: the rule each production of a grammar expands to for each
+// lookahead. Terminals that match the same tokens share a column, so
+// choosing a rule is one load per column the current token falls in.
+class ParseTable {
+  public:
+    using Symbol = Production::Symbol;
+
+    // Two rules predicted for the same lookahead. The earlier rule is kept.
+    // An empty rule is only predicted on FOLLOW and the end of input, so
+    // unlike the ordered search produce once did, it does not hide the rules
+    // after it on the rest of their FIRST sets.
+    struct Conflict {
+        const Production *production;
+        std::optional<Symbol> lookahead; // nullopt for the end of input
+        std::size_t rule;                // the rule kept
+        std::size_t other;               // the rule dropped
+    };
+
+    // Row k is the production g.rows()[k]. Reads only g's sets, so it can
+    // be built while g is.
+    ParseTable(const Grammar &g);
+
+    // The rule of row to expand on token, which is nullptr at the end of the
+    // input, or -1 if there is none. A token can fall in both a Token::Id
+    // column and a text column; the earlier of the two rules wins.
+    auto rule(std::size_t row, const Token *token) const -> int;
+    auto conflicts() const -> const std::vector<Conflict> & { return found; }
+
+  private:
+    std::size_t columnCount = 1; // column 0 is the end of input
+    std::vector<int> idColumn;   // by Token::Id, -1 if not a terminal
+    std::unordered_map<std::string, std::size_t> textColumn;
+    std::vector<int> cells;
+    // Taken when no cell predicts a rule: the first nullable rule, if any.
+    // Expanding it leaves the error to the symbol that follows.
+    std::vector<int> fallback;
+    std::vector<Conflict> found;
+
+    auto column(const Symbol &s) -> std::size_t;
+    void predict(const std::vector<const Production *> &rows,
+                 std::size_t row,
+                 std::size_t col,
+                 std::optional<Symbol> lookahead,
+                 std::size_t rule);
+};
+
+auto operator<<(std::ostream &os,
+                const ParseTable::Conflict &c) -> std::ostream &;
+
+} // namespace parser
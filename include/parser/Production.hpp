@@ -1,7 +1,10 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <initializer_list>
 #include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <unordered_set>
@@ -14,6 +17,10 @@
 
 namespace parser {
 
+class Cst;
+class Grammar;
+class ParseTable;
+
 struct Epsilon {};
 
 struct Terminal {
@@ -22,6 +29,15 @@ struct Terminal {
 
 struct NonTerminal {
     std::vector<std::variant<Epsilon, Terminal, NonTerminal>> children;
+
+    NonTerminal() = default;
+    NonTerminal(std::vector<std::variant<Epsilon, Terminal, NonTerminal>> c)
+        : children(std::move(c))
+    {}
+    NonTerminal(NonTerminal &&) = default;
+    auto operator=(NonTerminal &&) -> NonTerminal & = default;
+    // Frees nested children without recursing, however deep the tree.
+    ~NonTerminal();
 };
 
 class Production {
@@ -32,14 +48,42 @@ class Production {
     std::string name;
     static bool debug;
 
+    // Productions point at each other and guard their grammar() with a
+    // once_flag, so they can be neither copied nor moved: build them in
+    // place, or keep them in a container that never relocates them.
     Production() = default;
     Production(std::string name) : name(std::move(name)) {}
 
+    // Throws std::logic_error once a grammar() that reaches this production
+    // has been built, since that grammar would never see the new rule.
     void add(std::initializer_list<Symbol> symbols);
+
+    // The sets and LL(1) table of every production reachable from this one,
+    // taken as the goal. Built once, on first use, which includes the first
+    // produce or a call to nullable() or first(); every production it
+    // reaches is fixed from then on.
+    auto grammar() const -> const Grammar &;
+    // Builds grammar() up front.
+    void finalize() const;
+    // Looked up in grammar(). FOLLOW depends on the goal, so it is only
+    // found in the grammar() of a goal.
     auto nullable() const -> bool;
-    auto first() const -> std::unordered_set<Symbol>;
+    auto first() const -> const std::unordered_set<Symbol> &;
+    auto ruleCount() const -> std::size_t { return rules.size(); }
+    auto rule(std::size_t r) const -> const std::vector<Symbol> &
+    {
+        return rules.at(r);
+    }
+    auto ruleFirst(std::size_t r) const -> const std::unordered_set<Symbol> &;
+    auto ruleNullable(std::size_t r) const -> bool;
+    // The LL(1) table produce chooses rules from.
+    auto table() const -> const ParseTable &;
     auto produce(std::vector<std::unique_ptr<Token>> &tokens) -> Node;
     auto produce(ParseContext &ctx, bool isGoal = false) -> Node;
+    // Parses as produce does into a flat Cst, with a node for every
+    // production matched.
+    auto produceCst(std::vector<std::unique_ptr<Token>> &tokens) -> Cst;
+    auto produceCst(ParseContext &ctx, bool isGoal = false) -> Cst;
 
     friend auto operator<<(std::ostream &os,
                            const Production &p) -> std::ostream &;
@@ -50,8 +94,20 @@ class Production {
 
   private:
     std::vector<std::vector<Symbol>> rules;
+    mutable std::once_flag built;
+    mutable std::atomic<bool> frozen{false};
+    mutable std::shared_ptr<const Grammar> sets;
+
+    template<typename Builder>
+    void derive(ParseContext &ctx, bool isGoal, Builder &build);
 };
 
-} // namespace parser
+auto operator<<(std::ostream &os, const Production &p) -> std::ostream &;
+auto operator<<(std::ostream &os,
+                const std::vector<Production::Symbol> &rule) -> std::ostream &;
+auto operator<<(std::ostream &os,
+                const Production::Symbol &s) -> std::ostream &;
+auto operator<<(std::ostream &os,
+                const Production::Node &n) -> std::ostream &;
 
-#include "parser/Production.tpp" // IWYU pragma: keep
+} // namespace parser
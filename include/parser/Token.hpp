@@ -8,18 +8,29 @@ namespace parser {
 
 class Token {
   public:
+    using Id = int;
+
     std::string text;
 
     Token(char ch) : Token(std::to_string(ch)) {}
-    Token(std::string text) : text(std::move(text)) {}
+    Token(std::string text) : Token(std::move(text), id<Token>()) {}
+    Token(std::string text, Id typeId) : text(std::move(text)), typeId(typeId)
+    {}
     virtual ~Token() = default;
 
     /*============
      | Token Ids |
      ============*/
+    // Every token type T gets a dense id in [0, idCount()) the first time
+    // id<T>() is called. Lexer calls it when a token type is registered and
+    // stores the id in each token it constructs, so reading it back is a plain
+    // member load.
   public:
-    using Id = int;
-    virtual auto id() -> Id { return id<Token>(); }
+    // Subclasses used to override this to return their id<T>(). Lexer
+    // rejects a token type that still declares its own id(): pass id<T>()
+    // to the constructor instead, or let Lexer stamp it.
+    auto id() const -> Id { return typeId; }
+    void setId(Id id) { typeId = id; }
 
     template<typename T>
     static auto id() -> Id
@@ -27,10 +38,13 @@ class Token {
         static Id tokenId = newTokenId();
         return tokenId;
     }
+    static auto idCount() -> Id;
 
   private:
     static auto newTokenId() -> Id;
 
+    Id typeId;
+
     /*===========
      | Printing |
      ===========*/
@@ -0,0 +1,81 @@
+#include "lexer/ByteScanner.hpp"
+
+#include <cstddef>
+
+#include "lexer/State.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using lexer::ByteScanner;
+
+ByteScanner::ByteScanner(const CharSet &chars)
+{
+    unsigned count = 0;
+    for (unsigned b = 0; b < 256; b++) {
+        member[b] = chars.test(b);
+        if (!member[b]) {
+            continue;
+        }
+        if (b == 0 || !member[b - 1]) {
+            if (count < maxRanges) {
+                ranges[count].lo = static_cast<unsigned char>(b);
+            }
+            count++;
+        }
+        if (count <= maxRanges) {
+            ranges[count - 1].width =
+                static_cast<unsigned char>(b - ranges[count - 1].lo);
+        }
+    }
+    rangeCount = count;
+#if defined(__SSE2__)
+    vectorized = count > 0 && count <= maxRanges;
+#endif
+}
+
+auto ByteScanner::skip(const char *begin, const char *end) const
+    -> const char *
+{
+    const char *p = begin;
+    // Most runs are short, so settle the first byte before any vector setup.
+    if (p == end || !member[static_cast<unsigned char>(*p)]) {
+        return p;
+    }
+    p++;
+
+#if defined(__SSE2__)
+    if (vectorized) {
+        __m128i lo[maxRanges];
+        __m128i width[maxRanges];
+        for (unsigned r = 0; r < rangeCount; r++) {
+            lo[r] = _mm_set1_epi8(static_cast<char>(ranges[r].lo));
+            width[r] = _mm_set1_epi8(static_cast<char>(ranges[r].width));
+        }
+        const __m128i zero = _mm_setzero_si128();
+        while (end - p >= 16) {
+            __m128i v =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            // b is in [lo, lo + width] iff (b - lo) saturating-minus width
+            // is zero, with the subtraction wrapping.
+            __m128i in = zero;
+            for (unsigned r = 0; r < rangeCount; r++) {
+                __m128i offset = _mm_sub_epi8(v, lo[r]);
+                in = _mm_or_si128(
+                    in, _mm_cmpeq_epi8(_mm_subs_epu8(offset, width[r]), zero));
+            }
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(in));
+            if (mask != 0xFFFF) {
+                return p + __builtin_ctz(~mask);
+            }
+            p += 16;
+        }
+    }
+#endif
+
+    while (p != end && member[static_cast<unsigned char>(*p)]) {
+        p++;
+    }
+    return p;
+}
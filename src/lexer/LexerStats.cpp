@@ -0,0 +1,111 @@
+#include "lexer/LexerStats.hpp"
+
+#include <cstdio>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+using lexer::LexerStats;
+
+auto LexerStats::averageActive() const -> double
+{
+    if (steps == 0) {
+        return 0;
+    }
+    return static_cast<double>(activeMachines) / static_cast<double>(steps);
+}
+
+void LexerStats::clearCounters()
+{
+    for (Rule &rule : rules) {
+        rule.tokens = 0;
+        rule.bytes = 0;
+    }
+    steps = 0;
+    activeMachines = 0;
+    rollbacks = 0;
+    elapsed = std::chrono::nanoseconds(0);
+}
+
+void LexerStats::merge(const LexerStats &other)
+{
+    if (rules.size() < other.rules.size()) {
+        rules.resize(other.rules.size());
+    }
+    for (unsigned i = 0; i < other.rules.size(); i++) {
+        rules[i].pattern = other.rules[i].pattern;
+        rules[i].states = other.rules[i].states;
+        rules[i].tokens += other.rules[i].tokens;
+        rules[i].bytes += other.rules[i].bytes;
+    }
+    steps += other.steps;
+    activeMachines += other.activeMachines;
+    rollbacks += other.rollbacks;
+    elapsed += other.elapsed;
+}
+
+static void writeJsonString(std::ostream &o, const std::string &s)
+{
+    o << '"';
+    for (char c : s) {
+        switch (c) {
+        case '"':
+            o << "\\\"";
+            break;
+        case '\\':
+            o << "\\\\";
+            break;
+        case '\n':
+            o << "\\n";
+            break;
+        case '\t':
+            o << "\\t";
+            break;
+        case '\r':
+            o << "\\r";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                o << buf;
+            } else {
+                o << c;
+            }
+        }
+    }
+    o << '"';
+}
+
+auto LexerStats::toJson() const -> std::string
+{
+    std::stringstream ss;
+    ss << "{\"steps\":" << steps << ",\"activeMachines\":" << activeMachines
+       << ",\"averageActive\":" << averageActive()
+       << ",\"rollbacks\":" << rollbacks
+       << ",\"elapsedNs\":" << elapsed.count() << ",\"rules\":[";
+    for (unsigned i = 0; i < rules.size(); i++) {
+        const Rule &rule = rules[i];
+        if (i > 0) {
+            ss << ",";
+        }
+        ss << "{\"index\":" << i << ",\"pattern\":";
+        writeJsonString(ss, rule.pattern);
+        ss << ",\"states\":" << rule.states << ",\"tokens\":" << rule.tokens
+           << ",\"bytes\":" << rule.bytes << "}";
+    }
+    ss << "]}";
+    return ss.str();
+}
+
+auto lexer::operator<<(std::ostream &o, const LexerStats &s) -> std::ostream &
+{
+    o << "LexerStats(steps=" << s.steps << ", avgActive=" << s.averageActive()
+      << ", rollbacks=" << s.rollbacks << ", elapsedNs=" << s.elapsed.count() << ")\n";
+    for (unsigned i = 0; i < s.rules.size(); i++) {
+        const LexerStats::Rule &rule = s.rules[i];
+        o << "  [" << i << "] " << rule.pattern << ": states=" << rule.states
+          << " tokens=" << rule.tokens << " bytes=" << rule.bytes << "\n";
+    }
+    return o;
+}
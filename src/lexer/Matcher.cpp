@@ -0,0 +1,292 @@
+#include "lexer/Matcher.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lexer/ByteScanner.hpp"
+#include "lexer/RegexParsing.hpp"
+#include "lexer/State.hpp"
+#include "lexer/StateMachine.hpp"
+
+using RegexParsing::Alternatives;
+using RegexParsing::Matcher;
+using RegexParsing::Pattern;
+using lexer::State;
+
+// Adds the states reachable from set through epsilon states, then sorts it.
+static void closure(const std::vector<State> &states,
+                    std::vector<unsigned> &set)
+{
+    std::vector<bool> seen(states.size());
+    for (unsigned s : set) {
+        seen[s] = true;
+    }
+    for (std::size_t i = 0; i < set.size(); i++) {
+        for (unsigned e : states[set[i]].epsilonSuccessors) {
+            if (!seen[e]) {
+                seen[e] = true;
+                set.push_back(e);
+            }
+        }
+    }
+    std::sort(set.begin(), set.end());
+}
+
+// A set accepts if one of its states has an edge to Accept.
+static auto accepts(const std::vector<State> &states,
+                    const std::vector<unsigned> &set) -> bool
+{
+    return std::any_of(set.begin(), set.end(), [&](unsigned s) {
+        const std::vector<unsigned> &succ = states[s].successors;
+        return std::find(succ.begin(), succ.end(), State::Accept) != succ.end();
+    });
+}
+
+static void appendPieces(const Pattern &p, std::vector<const Pattern *> &out)
+{
+    if (p.type == Pattern::Concat) {
+        appendPieces(*p.opr1, out);
+        appendPieces(*p.opr2, out);
+    } else {
+        out.push_back(&p);
+    }
+}
+
+// The text of a Char or Literal piece, or nullopt for anything else.
+static auto pieceText(const Pattern &p) -> std::optional<std::string>
+{
+    if (p.type == Pattern::Char) {
+        return std::string(1, p.literalChar);
+    }
+    if (p.type == Pattern::Literal) {
+        return p.literal;
+    }
+    return std::nullopt;
+}
+
+Matcher::Matcher(const std::string &regex, const Limits &limits)
+    : Matcher(regex, Budget(limits))
+{}
+
+Matcher::Matcher(const std::string &regex, const Budget &budget)
+    : Matcher(std::make_shared<Pattern>(regex, budget), budget)
+{}
+
+Matcher::Matcher(const std::shared_ptr<Pattern> &p, const Budget &budget)
+{
+    std::shared_ptr<Pattern> opt = optimize(p, Alternatives::All);
+    budget.checkTime();
+
+    // Literal text that every match must start with or contain, taken from
+    // the top-level concatenation.
+    std::vector<const Pattern *> pieces;
+    appendPieces(*opt, pieces);
+    std::string run;
+    bool leading = true;
+    for (const Pattern *piece : pieces) {
+        if (std::optional<std::string> text = pieceText(*piece)) {
+            run += *text;
+        } else {
+            leading = false;
+            run.clear();
+        }
+        if (leading) {
+            prefix = run;
+        }
+        if (run.size() > required.size()) {
+            required = run;
+        }
+    }
+
+    lexer::StateMachine sm(toNode(opt, budget));
+    const std::vector<State> &states = sm.states;
+
+    // Bytes that every state treats alike share a class.
+    std::map<std::vector<bool>, unsigned char> classOf;
+    std::vector<unsigned char> representative;
+    for (unsigned b = 0; b < 256; b++) {
+        std::vector<bool> signature(states.size());
+        for (unsigned s = State::Reject + 1; s < states.size(); s++) {
+            signature[s] = states[s].chars.test(b);
+        }
+        auto [it, inserted] = classOf.emplace(
+            std::move(signature), static_cast<unsigned char>(classCount));
+        if (inserted) {
+            representative.push_back(static_cast<unsigned char>(b));
+            classCount++;
+        }
+        byteClass[b] = it->second;
+    }
+
+    // Subset construction. DFA state 0 is dead and 1 is the start.
+    std::map<std::vector<unsigned>, int> index;
+    std::vector<std::vector<unsigned>> sets;
+    auto intern = [&](std::vector<unsigned> set) {
+        if (set.empty()) {
+            return dead;
+        }
+        auto [it, inserted] =
+            index.emplace(set, static_cast<int>(sets.size()));
+        if (inserted) {
+            sets.push_back(std::move(set));
+        }
+        return it->second;
+    };
+    sets.emplace_back();
+    std::vector<unsigned> startSet{State::Enter};
+    closure(states, startSet);
+    intern(startSet);
+
+    for (std::size_t d = 0; d < sets.size(); d++) {
+        budget.checkDfaStates(sets.size() - 1);
+        budget.checkTime();
+        accepting.push_back(d != dead && accepts(states, sets[d]) ? 1 : 0);
+        next.resize(sets.size() * classCount, dead);
+        if (d == dead) {
+            continue;
+        }
+        for (unsigned k = 0; k < classCount; k++) {
+            auto c = static_cast<char>(representative[k]);
+            std::vector<unsigned> target;
+            for (unsigned s : sets[d]) {
+                for (unsigned n : states[s].successors) {
+                    if (n != State::Accept && states[n].matches(c)
+                        && std::find(target.begin(), target.end(), n)
+                               == target.end())
+                    {
+                        target.push_back(n);
+                    }
+                }
+            }
+            closure(states, target);
+            int t = intern(std::move(target));
+            next.resize(sets.size() * classCount, dead);
+            next[d * classCount + k] = t;
+        }
+    }
+    stateCount = sets.size();
+
+    for (unsigned b = 0; b < 256; b++) {
+        if (step(start, static_cast<char>(b)) != dead) {
+            firstBytes.set(b);
+        }
+    }
+    nonFirst.emplace(~firstBytes);
+}
+
+auto Matcher::fullMatch(std::string_view text) const -> bool
+{
+    int s = start;
+    for (char c : text) {
+        s = step(s, c);
+        if (s == dead) {
+            return false;
+        }
+    }
+    return accepting[s] != 0;
+}
+
+// The first position at or after pos where a match could start, or npos.
+auto Matcher::candidate(std::string_view text, std::size_t pos) const
+    -> std::size_t
+{
+    if (pos > text.size()) {
+        return std::string_view::npos;
+    }
+    if (accepting[start] != 0) {
+        return pos;
+    }
+    if (!prefix.empty()) {
+        while (pos + prefix.size() <= text.size()) {
+            const void *hit = std::memchr(
+                text.data() + pos, prefix[0], text.size() - pos);
+            if (hit == nullptr) {
+                break;
+            }
+            pos = static_cast<const char *>(hit) - text.data();
+            if (text.compare(pos, prefix.size(), prefix) == 0) {
+                return pos;
+            }
+            pos++;
+        }
+        return std::string_view::npos;
+    }
+    const char *end = text.data() + text.size();
+    const char *hit = nonFirst->skip(text.data() + pos, end);
+    return hit == end ? std::string_view::npos
+                      : static_cast<std::size_t>(hit - text.data());
+}
+
+auto Matcher::longestAt(std::string_view text, std::size_t pos) const
+    -> std::optional<std::size_t>
+{
+    std::optional<std::size_t> last;
+    int s = start;
+    if (accepting[s] != 0) {
+        last = pos;
+    }
+    for (std::size_t i = pos; i < text.size(); i++) {
+        s = step(s, text[i]);
+        if (s == dead) {
+            break;
+        }
+        if (accepting[s] != 0) {
+            last = i + 1;
+        }
+    }
+    return last;
+}
+
+auto Matcher::firstFrom(std::string_view text, std::size_t from) const
+    -> std::optional<Match>
+{
+    for (std::size_t pos = candidate(text, from); pos != text.npos;
+         pos = candidate(text, pos + 1))
+    {
+        if (std::optional<std::size_t> end = longestAt(text, pos)) {
+            return Match{pos, *end};
+        }
+    }
+    return std::nullopt;
+}
+
+auto Matcher::search(std::string_view text, std::size_t from) const
+    -> std::optional<Match>
+{
+    if (!required.empty() && text.find(required, from) == text.npos) {
+        return std::nullopt;
+    }
+    return firstFrom(text, from);
+}
+
+auto Matcher::findAll(std::string_view text, std::vector<Match> &out) const
+    -> std::size_t
+{
+    std::size_t count = 0;
+    // The first occurrence of the required literal at or after pos. Once it
+    // runs out, so do the matches.
+    std::size_t requiredAt = 0;
+    for (std::size_t pos = 0; pos <= text.size();) {
+        if (!required.empty() && (count == 0 || requiredAt < pos)) {
+            requiredAt = text.find(required, pos);
+            if (requiredAt == text.npos) {
+                break;
+            }
+        }
+        std::optional<Match> m = firstFrom(text, pos);
+        if (!m) {
+            break;
+        }
+        out.push_back(*m);
+        count++;
+        pos = m->end > m->begin ? m->end : m->end + 1;
+    }
+    return count;
+}
@@ -1,188 +1,103 @@
 #include "lexer/Node.hpp"
 
 #include <iostream>
-#include <memory>
 #include <utility>
+#include <vector>
 
 #include "lexer/State.hpp"
 
-using lexer::AlternateNode;
-using lexer::ConcatNode;
-using lexer::LiteralNode;
 using lexer::Node;
-using lexer::OptionalNode;
-using lexer::PlusNode;
-using lexer::StarNode;
 
-auto operator<<(std::ostream &o, const Node &n) -> std::ostream &
+auto lexer::operator<<(std::ostream &o, const Node &n) -> std::ostream &
 {
-    n.print(o);
+    o << "Node[" << n.states.size() << "," << n.root.entry.size() << ","
+      << n.root.exit.size() << "]";
     return o;
 }
 
-void Node::print(std::ostream &o) const
+Node::Node() : states(3)
 {
-    o << "Node[" << states.size() << "," << entry.size() << "," << exit.size()
-      << "]";
+    // Accept consumes any byte, which is how a machine signals that its
+    // token ended before the current byte.
+    states[State::Accept].chars.set();
 }
 
-LiteralNode::LiteralNode(const std::shared_ptr<State> &s)
+void Node::addEdge(unsigned from, unsigned to)
 {
-    states.push_back(s);
-    entry.push_back(s);
-    exit.push_back(s);
-    connect();
-}
-
-void LiteralNode::connect() {}
-
-void LiteralNode::print(std::ostream &o) const
-{
-    o << "LiteralNode[" << states.size() << "," << entry.size() << ","
-      << exit.size() << "]";
-}
-
-ConcatNode::ConcatNode(std::unique_ptr<Node> _left,
-                       std::unique_ptr<Node> _right)
-    : left(std::move(_left)),
-      right(std::move(_right))
-{
-    for (const auto &ls : left->states) {
-        states.push_back(ls);
-    }
-    for (const auto &rs : right->states) {
-        states.push_back(rs);
-    }
-    for (const auto &le : left->entry) {
-        entry.push_back(le);
-    }
-    for (const auto &rx : right->exit) {
-        exit.push_back(rx);
-    }
-
-    connect();
-}
+    State &f = states[from];
+    bool epsilon = states[to].isEpsilon();
+    std::vector<unsigned> &successors =
+        epsilon ? f.epsilonSuccessors : f.successors;
+    std::vector<std::vector<unsigned>> &tags =
+        epsilon ? f.epsilonSuccessorTags : f.successorTags;
+    successors.push_back(to);
 
-void ConcatNode::connect()
-{
-    for (const auto &lx : left->exit) {
-        for (const auto &re : right->entry) {
-            lx->addEdge(re);
-        }
+    const std::vector<unsigned> &open = states[to].openTags;
+    if (f.closeTags.empty() && open.empty() && tags.empty()) {
+        return;
     }
+    tags.resize(successors.size());
+    tags.back() = f.closeTags;
+    tags.back().insert(tags.back().end(), open.begin(), open.end());
 }
 
-void ConcatNode::print(std::ostream &o) const
+void Node::capture(const Fragment &f, unsigned group)
 {
-    o << "ConcatNode[" << states.size() << "," << entry.size() << ","
-      << exit.size() << "]";
-}
-
-AlternateNode::AlternateNode(std::unique_ptr<Node> _left,
-                             std::unique_ptr<Node> _right)
-    : left(std::move(_left)),
-      right(std::move(_right))
-{
-    for (const auto &ls : left->states) {
-        states.push_back(ls);
-    }
-    for (const auto &rs : right->states) {
-        states.push_back(rs);
-    }
-    for (const auto &le : left->entry) {
-        entry.push_back(le);
+    for (unsigned e : f.entry) {
+        states[e].openTags.push_back(2 * group);
     }
-    for (const auto &re : right->entry) {
-        entry.push_back(re);
+    for (unsigned x : f.exit) {
+        states[x].closeTags.push_back(2 * group + 1);
     }
-    for (const auto &lx : left->exit) {
-        exit.push_back(lx);
-    }
-    for (const auto &rx : right->exit) {
-        exit.push_back(rx);
-    }
-
-    connect();
-}
-
-void AlternateNode::connect() {}
-
-void AlternateNode::print(std::ostream &o) const
-{
-    o << "AlternateNode[" << states.size() << "," << entry.size() << ","
-      << exit.size() << "]";
 }
 
-PlusNode::PlusNode(std::unique_ptr<Node> _opr) : opr(std::move(_opr))
+auto Node::literal(const CharSet &chars) -> Fragment
 {
-    states = opr->states;
-    entry = opr->entry;
-    exit = opr->exit;
-    connect();
+    auto s = static_cast<unsigned>(states.size());
+    states.emplace_back().chars = chars;
+    return {{s}, {s}};
 }
 
-void PlusNode::connect()
+auto Node::concat(Fragment left, Fragment right) -> Fragment
 {
-    for (const auto &e : opr->entry) {
-        for (const auto &x : opr->exit) {
-            x->addEdge(e);
+    for (unsigned lx : left.exit) {
+        for (unsigned re : right.entry) {
+            addEdge(lx, re);
         }
     }
+    return {std::move(left.entry), std::move(right.exit)};
 }
 
-void PlusNode::print(std::ostream &o) const
-{
-    o << "PlusNode[" << states.size() << "," << entry.size() << ","
-      << exit.size() << "]";
-}
-
-StarNode::StarNode(std::unique_ptr<Node> _opr) : opr(std::move(_opr))
+auto Node::alternate(std::vector<Fragment> alternatives) -> Fragment
 {
-    states = opr->states;
-    entry = opr->entry;
-    exit = opr->exit;
-
-    std::shared_ptr<EpsilonState> epsilon = std::make_shared<EpsilonState>();
-    states.push_back(epsilon);
-    entry.push_back(epsilon);
-    exit.push_back(epsilon);
-
-    connect();
+    Fragment f;
+    for (Fragment &alt : alternatives) {
+        f.entry.insert(f.entry.end(), alt.entry.begin(), alt.entry.end());
+        f.exit.insert(f.exit.end(), alt.exit.begin(), alt.exit.end());
+    }
+    return f;
 }
 
-void StarNode::connect()
+auto Node::plus(Fragment opr) -> Fragment
 {
-    for (const auto &e : opr->entry) {
-        for (const auto &x : opr->exit) {
-            x->addEdge(e);
+    for (unsigned e : opr.entry) {
+        for (unsigned x : opr.exit) {
+            addEdge(x, e);
         }
     }
+    return opr;
 }
 
-void StarNode::print(std::ostream &o) const
+auto Node::star(Fragment opr) -> Fragment
 {
-    o << "StarNode[" << states.size() << "," << entry.size() << ","
-      << exit.size() << "]";
+    return optional(plus(std::move(opr)));
 }
 
-OptionalNode::OptionalNode(std::unique_ptr<Node> _opr) : opr(std::move(_opr))
-{
-    states = opr->states;
-    entry = opr->entry;
-    exit = opr->exit;
-
-    std::shared_ptr<EpsilonState> epsilon = std::make_shared<EpsilonState>();
-    states.push_back(epsilon);
-    entry.push_back(epsilon);
-    exit.push_back(epsilon);
-
-    connect();
-}
-
-void OptionalNode::connect() {}
-
-void OptionalNode::print(std::ostream &o) const
+auto Node::optional(Fragment opr) -> Fragment
 {
-    o << "OptionalNode[" << states.size() << "," << entry.size() << ","
-      << exit.size() << "]";
+    auto epsilon = static_cast<unsigned>(states.size());
+    states.emplace_back().epsilon = true;
+    opr.entry.push_back(epsilon);
+    opr.exit.push_back(epsilon);
+    return opr;
 }
@@ -0,0 +1,150 @@
+#include "lexer/Payload.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <string_view>
+
+using lexer::Payload;
+
+static auto hexDigit(char c) -> int
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static auto escaped(char c) -> char
+{
+    switch (c) {
+    case 'n':
+        return '\n';
+    case 't':
+        return '\t';
+    case 'r':
+        return '\r';
+    case 'b':
+        return '\b';
+    case 'f':
+        return '\f';
+    case 'v':
+        return '\v';
+    case 'a':
+        return '\a';
+    case '0':
+        return '\0';
+    default:
+        return c;
+    }
+}
+
+// Accumulates digits of the given base into integer, noting overflow.
+static auto accumulate(Payload &p, std::string_view text, unsigned base)
+    -> std::size_t
+{
+    constexpr std::uint64_t max = std::numeric_limits<std::uint64_t>::max();
+    std::size_t i = 0;
+    for (; i < text.size(); i++) {
+        int d = hexDigit(text[i]);
+        if (d < 0 || static_cast<unsigned>(d) >= base) {
+            break;
+        }
+        if (p.integer > (max - static_cast<unsigned>(d)) / base) {
+            p.overflow = true;
+        }
+        p.integer = p.integer * base + static_cast<unsigned>(d);
+    }
+    return i;
+}
+
+// Digits and an optional fraction. Up to 15 significant digits with a short
+// fraction are converted exactly from the accumulated integer, since both
+// it and the power of ten are exact doubles. Anything longer goes through
+// strtod to stay correctly rounded.
+static void decodeFloat(Payload &p, std::string_view text)
+{
+    constexpr double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                 1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                 1e18, 1e19, 1e20, 1e21, 1e22};
+    std::uint64_t mantissa = 0;
+    unsigned digits = 0;
+    unsigned fraction = 0;
+    bool point = false;
+    std::size_t i = 0;
+    for (; i < text.size(); i++) {
+        char c = text[i];
+        if (c == '.' && !point) {
+            point = true;
+        } else if (c >= '0' && c <= '9') {
+            if (mantissa != 0 || c != '0') {
+                digits++;
+            }
+            mantissa = mantissa * 10 + static_cast<unsigned>(c - '0');
+            fraction += point;
+        } else {
+            break;
+        }
+        if (digits > 15) {
+            break;
+        }
+    }
+    if (digits <= 15 && fraction < sizeof(powers) / sizeof(powers[0])) {
+        p.real = static_cast<double>(mantissa) / powers[fraction];
+        return;
+    }
+    std::string copy(text);
+    p.real = std::strtod(copy.c_str(), nullptr);
+}
+
+void Payload::decode(Kind k, std::string_view text)
+{
+    kind = k;
+    integer = 0;
+    overflow = false;
+    real = 0;
+    string.clear();
+
+    switch (k) {
+    case Decimal:
+        accumulate(*this, text, 10);
+        break;
+    case Hex:
+        if (text.size() >= 2 && text[0] == '0'
+            && (text[1] == 'x' || text[1] == 'X'))
+        {
+            text.remove_prefix(2);
+        }
+        accumulate(*this, text, 16);
+        break;
+    case Float:
+        decodeFloat(*this, text);
+        break;
+    case String: {
+        if (!text.empty() && (text.front() == '"' || text.front() == '\'')) {
+            char quote = text.front();
+            text.remove_prefix(1);
+            if (!text.empty() && text.back() == quote) {
+                text.remove_suffix(1);
+            }
+        }
+        for (std::size_t i = 0; i < text.size(); i++) {
+            if (text[i] == '\\' && i + 1 < text.size()) {
+                string.push_back(escaped(text[++i]));
+            } else {
+                string.push_back(text[i]);
+            }
+        }
+        break;
+    }
+    }
+}
@@ -0,0 +1,66 @@
+#include "lexer/RegexLimits.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+#include "lexer/RegexException.hpp"
+
+using RegexParsing::Budget;
+using RegexParsing::RegexException;
+
+Budget::Budget(const Limits &limits,
+               std::chrono::steady_clock::time_point start)
+    : limits(limits), deadline(start + limits.maxCompileTime)
+{}
+
+void Budget::checkLength(std::size_t length) const
+{
+    if (limits.maxLength != 0 && length > limits.maxLength) {
+        throw RegexException(RegexException::TooLong,
+                             "pattern is longer than "
+                                 + std::to_string(limits.maxLength)
+                                 + " bytes");
+    }
+}
+
+void Budget::checkNesting(unsigned depth) const
+{
+    if (limits.maxNesting != 0 && depth > limits.maxNesting) {
+        throw RegexException(RegexException::TooDeep,
+                             "groups are nested deeper than "
+                                 + std::to_string(limits.maxNesting));
+    }
+}
+
+void Budget::checkNfaStates(std::size_t states) const
+{
+    if (limits.maxNfaStates != 0 && states > limits.maxNfaStates) {
+        throw RegexException(RegexException::TooManyNfaStates,
+                             "NFA has more than "
+                                 + std::to_string(limits.maxNfaStates)
+                                 + " states");
+    }
+}
+
+void Budget::checkDfaStates(std::size_t states) const
+{
+    if (limits.maxDfaStates != 0 && states > limits.maxDfaStates) {
+        throw RegexException(RegexException::TooManyDfaStates,
+                             "automaton has more than "
+                                 + std::to_string(limits.maxDfaStates)
+                                 + " states");
+    }
+}
+
+void Budget::checkTime() const
+{
+    if (limits.maxCompileTime.count() != 0
+        && std::chrono::steady_clock::now() > deadline)
+    {
+        throw RegexException(RegexException::Timeout,
+                             "compiling took longer than "
+                                 + std::to_string(limits.maxCompileTime.count())
+                                 + " ms");
+    }
+}
@@ -0,0 +1,548 @@
+#include "lexer/RegexParsing.hpp"
+
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "lexer/State.hpp"
+
+using RegexParsing::Alternatives;
+using RegexParsing::Pattern;
+using PatternPtr = std::shared_ptr<Pattern>;
+using Sequence = std::vector<PatternPtr>;
+
+#define DBG                     \
+    if (!RegexParsing::debug) { \
+    } else                      \
+        std::cerr
+
+/*=============
+ | Factories |
+ =============*/
+
+static auto makeChar(char c) -> PatternPtr
+{
+    auto p = std::make_shared<Pattern>();
+    p->type = Pattern::Char;
+    p->literalChar = c;
+    return p;
+}
+
+static auto makeChoice(const lexer::CharSet &chars) -> PatternPtr
+{
+    if (chars.count() == 1) {
+        for (unsigned b = 0; b < chars.size(); b++) {
+            if (chars.test(b)) {
+                return makeChar(static_cast<char>(b));
+            }
+        }
+    }
+    auto p = std::make_shared<Pattern>();
+    p->type = Pattern::CharChoice;
+    p->charChoicePred = [chars](char c) {
+        return chars.test(static_cast<unsigned char>(c));
+    };
+    p->charChoiceChars = chars;
+    return p;
+}
+
+static auto makeUnary(Pattern::Type type, PatternPtr opr) -> PatternPtr
+{
+    auto p = std::make_shared<Pattern>();
+    p->type = type;
+    p->opr1 = std::move(opr);
+    return p;
+}
+
+static auto makeBinary(Pattern::Type type,
+                       PatternPtr left,
+                       PatternPtr right) -> PatternPtr
+{
+    auto p = std::make_shared<Pattern>();
+    p->type = type;
+    p->opr1 = std::move(left);
+    p->opr2 = std::move(right);
+    return p;
+}
+
+static auto isSingleChar(const Pattern &p) -> bool
+{
+    return p.type == Pattern::Char || p.type == Pattern::CharChoice;
+}
+
+// Structural equality. CharChoices are compared by the bytes they match.
+static auto equal(const Pattern &a, const Pattern &b) -> bool
+{
+    if (a.type == Pattern::Char && b.type == Pattern::Char) {
+        return a.literalChar == b.literalChar;
+    }
+    if (isSingleChar(a) && isSingleChar(b)) {
+        return RegexParsing::charSet(a) == RegexParsing::charSet(b);
+    }
+    if (a.type != b.type) {
+        return false;
+    }
+    switch (a.type) {
+    case Pattern::Char:
+    case Pattern::CharChoice:
+        return true; // handled above
+    case Pattern::Literal:
+        return a.literal == b.literal;
+    case Pattern::Concat:
+    case Pattern::Alternate:
+        return equal(*a.opr1, *b.opr1) && equal(*a.opr2, *b.opr2);
+    case Pattern::Plus:
+    case Pattern::Star:
+    case Pattern::Optional:
+        return equal(*a.opr1, *b.opr1);
+    }
+    return false;
+}
+
+/*=============
+ | Sequences |
+ =============*/
+
+// Flattens nested Concats into their pieces, expanding Literals into Chars.
+static void appendAtoms(const PatternPtr &p, Sequence &atoms)
+{
+    if (p->type == Pattern::Concat) {
+        appendAtoms(p->opr1, atoms);
+        appendAtoms(p->opr2, atoms);
+    } else if (p->type == Pattern::Literal) {
+        for (char c : p->literal) {
+            atoms.push_back(makeChar(c));
+        }
+    } else {
+        atoms.push_back(p);
+    }
+}
+
+static auto atoms(const PatternPtr &p) -> Sequence
+{
+    Sequence seq;
+    appendAtoms(p, seq);
+    return seq;
+}
+
+static auto mergeQuantifiers(const PatternPtr &a,
+                             const PatternPtr &b) -> PatternPtr;
+
+// Joins atoms back into a right-deep Concat. Runs of Chars become a single
+// Literal and adjacent quantified copies of the same pattern are merged.
+// Returns nullptr for an empty sequence.
+static auto concat(const Sequence &seq) -> PatternPtr
+{
+    Sequence pieces;
+    for (const PatternPtr &atom : seq) {
+        if (!pieces.empty()) {
+            if (PatternPtr merged = mergeQuantifiers(pieces.back(), atom)) {
+                pieces.back() = merged;
+                continue;
+            }
+        }
+        pieces.push_back(atom);
+    }
+
+    Sequence runs;
+    for (std::size_t i = 0; i < pieces.size(); i++) {
+        std::size_t j = i;
+        std::string literal;
+        while (j < pieces.size() && pieces[j]->type == Pattern::Char) {
+            literal += pieces[j]->literalChar;
+            j++;
+        }
+        if (literal.size() < 2) {
+            runs.push_back(pieces[i]);
+            continue;
+        }
+        auto run = std::make_shared<Pattern>();
+        run->type = Pattern::Literal;
+        run->literal = std::move(literal);
+        runs.push_back(run);
+        i = j - 1;
+    }
+
+    PatternPtr result;
+    for (auto it = runs.rbegin(); it != runs.rend(); ++it) {
+        result = result ? makeBinary(Pattern::Concat, *it, result) : *it;
+    }
+    return result;
+}
+
+/*===============
+ | Quantifiers |
+ ===============*/
+
+// Collapses a quantifier applied directly to another quantifier, e.g.
+// (a*)* => a*, (a+)? => a*, (a?)+ => a*, (a+)+ => a+. For First a loop
+// around a star or optional is kept: a rule's machine can circle its empty
+// path, and then rejects where the collapsed one would accept.
+static auto collapse(Pattern::Type outer,
+                     PatternPtr opr,
+                     Alternatives mode) -> PatternPtr
+{
+    while (opr->type == Pattern::Plus || opr->type == Pattern::Star
+           || opr->type == Pattern::Optional)
+    {
+        if (mode == Alternatives::First && outer != Pattern::Optional
+            && opr->type != Pattern::Plus)
+        {
+            break;
+        }
+        if (opr->type == outer) {
+            return opr;
+        }
+        outer = Pattern::Star; // any other pair of quantifiers is a star
+        opr = opr->opr1;
+    }
+    return makeUnary(outer, opr);
+}
+
+static auto nullable(const Pattern &p) -> bool
+{
+    switch (p.type) {
+    case Pattern::Char:
+    case Pattern::CharChoice:
+    case Pattern::Literal:
+        return false;
+    case Pattern::Concat:
+        return nullable(*p.opr1) && nullable(*p.opr2);
+    case Pattern::Alternate:
+        return nullable(*p.opr1) || nullable(*p.opr2);
+    case Pattern::Plus:
+        return nullable(*p.opr1);
+    case Pattern::Star:
+    case Pattern::Optional:
+        return true;
+    }
+    return false;
+}
+
+// a*a* => a*, a+a* => a+. a*a+ is left alone: a rule's machine keeps taking
+// the a* and never reaches the a+, so it matches nothing. So is a loop around
+// a nullable pattern, whose empty path the machine can circle.
+static auto mergeQuantifiers(const PatternPtr &a,
+                             const PatternPtr &b) -> PatternPtr
+{
+    bool aStar = a->type == Pattern::Star;
+    bool aPlus = a->type == Pattern::Plus;
+    if (b->type != Pattern::Star || !(aStar || aPlus)) {
+        return nullptr;
+    }
+    if (nullable(*a->opr1) || !equal(*a->opr1, *b->opr1)) {
+        return nullptr;
+    }
+    return a;
+}
+
+/*================
+ | Alternatives |
+ ================*/
+
+static auto optimizeAlternatives(std::vector<Sequence> alts,
+                                 Alternatives mode) -> PatternPtr;
+
+static void appendAlternatives(const PatternPtr &p, std::vector<Sequence> &alts)
+{
+    if (p->type == Pattern::Alternate) {
+        appendAlternatives(p->opr1, alts);
+        appendAlternatives(p->opr2, alts);
+    } else {
+        alts.push_back(atoms(p));
+    }
+}
+
+// Keys longer than this are not worth comparing: they belong to alternatives
+// that already contain factored sub-alternations, which rarely repeat.
+static constexpr std::size_t maxKeyLength = 256;
+
+// A string that is equal for structurally equal patterns. Returns false once
+// the key grows past maxKeyLength.
+static auto appendKey(const Pattern &p, std::string &key) -> bool
+{
+    if (key.size() > maxKeyLength) {
+        return false;
+    }
+    switch (p.type) {
+    case Pattern::Char:
+        key += "[c";
+        key += p.literalChar;
+        key += ']';
+        return true;
+    case Pattern::CharChoice: {
+        lexer::CharSet chars = RegexParsing::charSet(p);
+        key += '[';
+        for (unsigned b = 0; b < chars.size(); b += 8) {
+            char packed = 0;
+            for (unsigned k = 0; k < 8; k++) {
+                packed = static_cast<char>(packed | chars[b + k] << k);
+            }
+            key += packed;
+        }
+        key += ']';
+        return true;
+    }
+    case Pattern::Literal:
+        for (char c : p.literal) {
+            key += "[c";
+            key += c;
+            key += ']';
+        }
+        return true;
+    case Pattern::Concat:
+    case Pattern::Alternate:
+        key += p.type == Pattern::Concat ? "(." : "(|";
+        if (!appendKey(*p.opr1, key) || !appendKey(*p.opr2, key)) {
+            return false;
+        }
+        key += ')';
+        return true;
+    case Pattern::Plus:
+    case Pattern::Star:
+    case Pattern::Optional:
+        key += p.type == Pattern::Plus   ? "(+"
+               : p.type == Pattern::Star ? "(*"
+                                         : "(?";
+        if (!appendKey(*p.opr1, key)) {
+            return false;
+        }
+        key += ')';
+        return true;
+    }
+    return false;
+}
+
+// Returns false if the sequence is too large to key.
+static auto sequenceKey(const Sequence &seq, std::string &key) -> bool
+{
+    for (const PatternPtr &atom : seq) {
+        if (!appendKey(*atom, key)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Splits a group of alternatives that share their first (fromBack=false) or
+// last atom into that atom and the alternation of what remains.
+static auto factorGroup(std::vector<Sequence> group,
+                        bool fromBack,
+                        Alternatives mode) -> Sequence
+{
+    PatternPtr common = fromBack ? group.front().back() : group.front().front();
+    std::vector<Sequence> rests;
+    for (Sequence &seq : group) {
+        rests.emplace_back(fromBack ? seq.begin() : seq.begin() + 1,
+                           fromBack ? seq.end() - 1 : seq.end());
+    }
+    Sequence merged;
+    if (!fromBack) {
+        merged.push_back(common);
+    }
+    if (PatternPtr rest = optimizeAlternatives(std::move(rests), mode)) {
+        appendAtoms(rest, merged);
+    }
+    if (fromBack) {
+        merged.push_back(common);
+    }
+    return merged;
+}
+
+// Drops the alternatives a rule's machine can never take. On each byte it
+// enters the first alternative whose first atom matches and never backtracks,
+// so an alternative is dead once earlier ones start with every byte it can
+// start with: "a"|"ab" only ever matches a.
+static void dropShadowed(std::vector<Sequence> &alts)
+{
+    lexer::CharSet taken; // the bytes of earlier single-character first atoms
+    std::vector<Sequence> result;
+    for (Sequence &alt : alts) {
+        const Pattern &first = *alt.front();
+        if (isSingleChar(first)) {
+            lexer::CharSet chars = RegexParsing::charSet(first);
+            if ((chars & ~taken).none()) {
+                continue;
+            }
+            taken |= chars;
+        }
+        result.push_back(std::move(alt));
+    }
+    alts = std::move(result);
+}
+
+// Groups alternatives that start with the same atom. An alternative may be
+// pulled forward past others only if they cannot start with the same byte, so
+// the order in which a byte's alternatives are tried does not change. Only
+// used for All, since a rule's machine never takes the later ones.
+static void factorPrefixes(std::vector<Sequence> &alts)
+{
+    std::vector<bool> used(alts.size(), false);
+    std::vector<Sequence> result;
+    for (std::size_t i = 0; i < alts.size(); i++) {
+        if (used[i]) {
+            continue;
+        }
+        std::vector<Sequence> group{std::move(alts[i])};
+        const PatternPtr first = group[0].front();
+        if (isSingleChar(*first)) {
+            lexer::CharSet chars = RegexParsing::charSet(*first);
+            for (std::size_t j = i + 1; j < alts.size(); j++) {
+                if (used[j]) {
+                    continue;
+                }
+                const Pattern &other = *alts[j].front();
+                if (!isSingleChar(other)) {
+                    break;
+                }
+                lexer::CharSet otherChars = RegexParsing::charSet(other);
+                if (otherChars == chars) {
+                    group.push_back(std::move(alts[j]));
+                    used[j] = true;
+                } else if ((otherChars & chars).any()) {
+                    break;
+                }
+            }
+        } else {
+            for (std::size_t j = i + 1; j < alts.size() && !used[j]; j++) {
+                if (!equal(*first, *alts[j].front())) {
+                    break;
+                }
+                group.push_back(std::move(alts[j]));
+                used[j] = true;
+            }
+        }
+        if (group.size() == 1) {
+            result.push_back(std::move(group[0]));
+        } else {
+            result.push_back(
+                factorGroup(std::move(group), false, Alternatives::All));
+        }
+    }
+    alts = std::move(result);
+}
+
+// Groups adjacent alternatives that end with the same atom. The factored
+// group is optional if one of them is just that atom, and a rule's machine
+// tries the empty choice last, so for First that alternative must end its
+// group: "b"|[ab]b stays as it is rather than becoming [ab]?b.
+static void factorSuffixes(std::vector<Sequence> &alts, Alternatives mode)
+{
+    std::vector<Sequence> result;
+    for (std::size_t i = 0; i < alts.size(); i++) {
+        std::size_t j = i + 1;
+        while (j < alts.size() && equal(*alts[i].back(), *alts[j].back())) {
+            if (mode == Alternatives::First
+                && (alts[j - 1].size() == 1 || alts[j].size() == 1))
+            {
+                break;
+            }
+            j++;
+        }
+        if (j - i == 1) {
+            result.push_back(std::move(alts[i]));
+            continue;
+        }
+        std::vector<Sequence> group(std::make_move_iterator(alts.begin() + i),
+                                    std::make_move_iterator(alts.begin() + j));
+        result.push_back(factorGroup(std::move(group), true, mode));
+        i = j - 1;
+    }
+    alts = std::move(result);
+}
+
+// Builds the alternation of alts. An empty alternative makes the result
+// optional; nullptr is returned if every alternative is empty.
+static auto optimizeAlternatives(std::vector<Sequence> alts,
+                                 Alternatives mode) -> PatternPtr
+{
+    // Drop duplicates; a later copy of an alternative can never be chosen.
+    bool hasEmpty = false;
+    std::vector<Sequence> unique;
+    std::unordered_set<std::string> seen;
+    std::string key;
+    for (Sequence &alt : alts) {
+        key.clear();
+        if (alt.empty()) {
+            hasEmpty = true;
+        } else if (!sequenceKey(alt, key) || seen.insert(key).second) {
+            unique.push_back(std::move(alt));
+        }
+    }
+    alts = std::move(unique);
+
+    if (mode == Alternatives::First) {
+        dropShadowed(alts);
+    } else {
+        factorPrefixes(alts);
+    }
+    factorSuffixes(alts, mode);
+
+    // Merge runs of adjacent single-character alternatives into one choice.
+    Sequence choices;
+    for (std::size_t i = 0; i < alts.size(); i++) {
+        if (alts[i].size() == 1 && isSingleChar(*alts[i][0])) {
+            lexer::CharSet chars;
+            std::size_t j = i;
+            while (j < alts.size() && alts[j].size() == 1
+                   && isSingleChar(*alts[j][0]))
+            {
+                chars |= RegexParsing::charSet(*alts[j][0]);
+                j++;
+            }
+            choices.push_back(j - i > 1 ? makeChoice(chars) : alts[i][0]);
+            i = j - 1;
+        } else if (PatternPtr p = concat(alts[i])) {
+            choices.push_back(p);
+        }
+    }
+
+    PatternPtr result;
+    for (auto it = choices.rbegin(); it != choices.rend(); ++it) {
+        result = result ? makeBinary(Pattern::Alternate, *it, result) : *it;
+    }
+    if (result && hasEmpty) {
+        result = collapse(Pattern::Optional, result, mode);
+    }
+    return result;
+}
+
+/*=========
+ | Entry |
+ =========*/
+
+auto RegexParsing::optimize(const PatternPtr &p,
+                            Alternatives alternatives) -> PatternPtr
+{
+    switch (p->type) {
+    case Pattern::Char:
+    case Pattern::Literal:
+        return p;
+    case Pattern::CharChoice:
+        return makeChoice(charSet(*p));
+    case Pattern::Plus:
+    case Pattern::Star:
+    case Pattern::Optional:
+        return collapse(
+            p->type, optimize(p->opr1, alternatives), alternatives);
+    case Pattern::Concat: {
+        Sequence seq = atoms(optimize(p->opr1, alternatives));
+        Sequence right = atoms(optimize(p->opr2, alternatives));
+        seq.insert(seq.end(), right.begin(), right.end());
+        return concat(seq);
+    }
+    case Pattern::Alternate: {
+        std::vector<Sequence> alts;
+        appendAlternatives(optimize(p->opr1, alternatives), alts);
+        appendAlternatives(optimize(p->opr2, alternatives), alts);
+        DBG << "optimize: " << alts.size() << " alternatives\n";
+        return optimizeAlternatives(std::move(alts), alternatives);
+    }
+    }
+    return p;
+}
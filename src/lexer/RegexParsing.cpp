@@ -1,9 +1,11 @@
 #include "lexer/RegexParsing.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cctype>
 #include <cstddef>
 #include <cstdio>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <sstream>
@@ -12,6 +14,8 @@
 #include <vector>
 
 #include "lexer/Node.hpp"
+#include "lexer/RegexException.hpp"
+#include "lexer/RegexLimits.hpp"
 #include "lexer/State.hpp"
 
 using namespace RegexParsing;
@@ -92,7 +96,10 @@ auto RegexParsing::tokenize(const std::string &text) -> std::vector<int>
                 break;
             case '\\':
                 c = text[++i];
-                assert(c != '\0');
+                if (c == '\0') {
+                    throw RegexException(RegexException::Invalid,
+                                         "trailing \\ in " + text);
+                }
                 addLiteral(tokens, escape(c));
                 break;
             case '-':
@@ -107,7 +114,10 @@ auto RegexParsing::tokenize(const std::string &text) -> std::vector<int>
         switch (c) {
         case '\\':
             c = text[++i];
-            assert(c != '\0');
+            if (c == '\0') {
+                throw RegexException(RegexException::Invalid,
+                                     "trailing \\ in " + text);
+            }
             addLiteral(tokens, escape(c));
             break;
         case '[':
@@ -258,7 +268,7 @@ auto RegexParsing::validate(const std::vector<int> &tokens) -> bool
     }
     for (unsigned i = 1; i < tokens.size(); i++) {
         if (!equalsSpecial(tokens[i], '+') && !equalsSpecial(tokens[i], '*')
-            && !equalsSpecial(tokens[i], '*'))
+            && !equalsSpecial(tokens[i], '?'))
         {
             continue;
         }
@@ -310,6 +320,17 @@ auto RegexParsing::tokensToString(const std::vector<int> &tokens) -> std::string
     return ss.str();
 }
 
+static auto predChars(const std::function<bool(char)> &pred) -> lexer::CharSet
+{
+    lexer::CharSet chars;
+    for (unsigned b = 0; b < chars.size(); b++) {
+        if (pred(static_cast<char>(b))) {
+            chars.set(b);
+        }
+    }
+    return chars;
+}
+
 /* decomposition:
  * - if everything is wrapped in ()
  *     - unwrap recursively
@@ -337,19 +358,65 @@ auto RegexParsing::tokensToString(const std::vector<int> &tokens) -> std::string
  *     - assert the only char is a literal or -'.'
  */
 RegexParsing::Pattern::Pattern(const std::string &text)
-    : Pattern(tokenize(text))
+    : Pattern(text, Budget())
 {}
 
-// NOLINTNEXTLINE(readability-function-cognitive-complexity)
 RegexParsing::Pattern::Pattern(const std::vector<int> &tokens)
+    : Pattern(tokens, Budget())
+{}
+
+static auto checkedTokens(const std::string &text, const Budget &budget)
+    -> std::vector<int>
 {
-    DBG << "Constructing pattern with text: " << tokensToString(tokens) << "\n";
-    assert(validate(tokens));
+    budget.checkLength(text.size());
+    return tokenize(text);
+}
+
+RegexParsing::Pattern::Pattern(const std::string &text, const Budget &budget)
+    : Pattern(checkedTokens(text, budget), budget)
+{}
+
+RegexParsing::Pattern::Pattern(const std::vector<int> &tokens,
+                               const Budget &budget)
+{
+    budget.checkLength(tokens.size());
+    if (!validate(tokens)) {
+        throw RegexException(RegexException::Invalid,
+                             "malformed pattern " + tokensToString(tokens));
+    }
+    int depth = 0;
+    int maxDepth = 0;
+    for (int token : tokens) {
+        if (equalsSpecial(token, '(')) {
+            maxDepth = std::max(maxDepth, ++depth);
+        } else if (equalsSpecial(token, ')')) {
+            depth--;
+        }
+    }
+    budget.checkNesting(static_cast<unsigned>(maxDepth));
+    parse(tokens, 0, tokens.size(), budget);
+}
+
+// Fills in this pattern from tokens[begin, end), which have already been
+// validated. The operands are parsed from subranges of the same tokens, so
+// nothing is copied per level.
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+void RegexParsing::Pattern::parse(const std::vector<int> &tokens,
+                                  std::size_t begin,
+                                  std::size_t end,
+                                  const Budget &budget)
+{
+    auto range = [&](std::size_t from, std::size_t to) {
+        return tokensToString(
+            std::vector<int>(tokens.begin() + from, tokens.begin() + to));
+    };
+    DBG << "Constructing pattern with text: " << range(begin, end) << "\n";
+    budget.checkTime();
 
     // if everything is wrapped in ()
     bool wrapped = true;
     int depth = 0;
-    for (unsigned i = 0; i < tokens.size() - 1; i++) {
+    for (std::size_t i = begin; i < end - 1; i++) {
         if (equalsSpecial(tokens[i], '(')) {
             depth++;
         } else if (equalsSpecial(tokens[i], ')')) {
@@ -360,50 +427,31 @@ RegexParsing::Pattern::Pattern(const std::vector<int> &tokens)
             break;
         }
     }
-    if (!equalsSpecial(tokens[tokens.size() - 1], ')')) {
+    if (!equalsSpecial(tokens[end - 1], ')')) {
         wrapped = false;
     }
     if (wrapped) {
-        auto inner = std::vector<int>(tokens.begin() + 1, tokens.end() - 1);
-        DBG << "Wrapped: inner=" << tokensToString(inner) << "\n";
-        Pattern p(inner);
-        type = p.type;
-        switch (type) {
-        case Char:
-            literalChar = p.literalChar;
-            break;
-        case CharChoice:
-            charChoicePred = p.charChoicePred;
-            break;
-        case Concat:
-        case Alternate:
-            opr1 = std::move(p.opr1);
-            opr2 = std::move(p.opr2);
-            break;
-        case Plus:
-        case Star:
-        case Optional:
-            opr1 = std::move(p.opr1);
-            break;
-        }
+        DBG << "Wrapped: inner=" << range(begin + 1, end - 1) << "\n";
+        parse(tokens, begin + 1, end - 1, budget);
+        captures++;
         return;
     }
 
     // check for alternation
     depth = 0;
-    for (unsigned i = 0; i < tokens.size(); i++) {
+    for (std::size_t i = begin; i < end; i++) {
         if (equalsSpecial(tokens[i], '(')) {
             depth++;
         } else if (equalsSpecial(tokens[i], ')')) {
             depth--;
         } else if (depth == 0 && equalsSpecial(tokens[i], '|')) {
-            auto left = std::vector<int>(tokens.begin(), tokens.begin() + i);
-            auto right = std::vector<int>(tokens.begin() + i + 1, tokens.end());
-            DBG << "Alternate: left=" << tokensToString(left)
-                << " right=" << tokensToString(right) << "\n";
+            DBG << "Alternate: left=" << range(begin, i)
+                << " right=" << range(i + 1, end) << "\n";
             type = Alternate;
-            opr1 = std::make_unique<Pattern>(left);
-            opr2 = std::make_unique<Pattern>(right);
+            opr1 = std::make_shared<Pattern>();
+            opr1->parse(tokens, begin, i, budget);
+            opr2 = std::make_shared<Pattern>();
+            opr2->parse(tokens, i + 1, end, budget);
             return;
         }
     }
@@ -411,7 +459,7 @@ RegexParsing::Pattern::Pattern(const std::vector<int> &tokens)
     // check for concatenation
     depth = 0;
     int nPieces = 0;
-    for (unsigned i = 0; i < tokens.size(); i++) {
+    for (std::size_t i = begin; i < end; i++) {
         if (depth == 0 && !equalsSpecial(tokens[i], '+')
             && !equalsSpecial(tokens[i], '+') && !equalsSpecial(tokens[i], '*')
             && !equalsSpecial(tokens[i], '?'))
@@ -426,43 +474,44 @@ RegexParsing::Pattern::Pattern(const std::vector<int> &tokens)
             depth--;
         }
         if (nPieces > 1) {
-            auto left = std::vector<int>(tokens.begin(), tokens.begin() + i);
-            auto right = std::vector<int>(tokens.begin() + i, tokens.end());
-            DBG << "Concat: left=" << tokensToString(left)
-                << " right=" << tokensToString(right) << "\n";
+            DBG << "Concat: left=" << range(begin, i)
+                << " right=" << range(i, end) << "\n";
             type = Concat;
-            opr1 = std::make_unique<Pattern>(left);
-            opr2 = std::make_unique<Pattern>(right);
+            opr1 = std::make_shared<Pattern>();
+            opr1->parse(tokens, begin, i, budget);
+            opr2 = std::make_shared<Pattern>();
+            opr2->parse(tokens, i, end, budget);
             return;
         }
     }
 
     // check for plus/star/opt
-    if (equalsSpecial(tokens[tokens.size() - 1], '+')) {
-        auto inner = std::vector<int>(tokens.begin(), tokens.end() - 1);
-        DBG << "Plus: inner=" << tokensToString(inner) << "\n";
+    if (equalsSpecial(tokens[end - 1], '+')) {
+        DBG << "Plus: inner=" << range(begin, end - 1) << "\n";
         type = Plus;
-        opr1 = std::make_unique<Pattern>(inner);
+        opr1 = std::make_shared<Pattern>();
+        opr1->parse(tokens, begin, end - 1, budget);
         return;
     }
-    if (equalsSpecial(tokens[tokens.size() - 1], '*')) {
-        auto inner = std::vector<int>(tokens.begin(), tokens.end() - 1);
-        DBG << "Star: inner=" << tokensToString(inner) << "\n";
+    if (equalsSpecial(tokens[end - 1], '*')) {
+        DBG << "Star: inner=" << range(begin, end - 1) << "\n";
         type = Star;
-        opr1 = std::make_unique<Pattern>(inner);
+        opr1 = std::make_shared<Pattern>();
+        opr1->parse(tokens, begin, end - 1, budget);
         return;
     }
-    if (equalsSpecial(tokens[tokens.size() - 1], '?')) {
-        auto inner = std::vector<int>(tokens.begin(), tokens.end() - 1);
-        DBG << "Optional: inner=" << tokensToString(inner) << "\n";
+    if (equalsSpecial(tokens[end - 1], '?')) {
+        DBG << "Optional: inner=" << range(begin, end - 1) << "\n";
         type = Optional;
-        opr1 = std::make_unique<Pattern>(inner);
+        opr1 = std::make_shared<Pattern>();
+        opr1->parse(tokens, begin, end - 1, budget);
         return;
     }
 
     // check for charchoice
-    if (equalsSpecial(tokens[0], '[')) {
-        auto inner = std::vector<int>(tokens.begin() + 1, tokens.end() - 1);
+    if (equalsSpecial(tokens[begin], '[')) {
+        auto inner = std::vector<int>(tokens.begin() + begin + 1,
+                                      tokens.begin() + end - 1);
         DBG << "CharChoice: inner=" << tokensToString(inner) << "\n";
         type = CharChoice;
         if (equalsSpecial(inner[0], '^')) {
@@ -512,65 +561,198 @@ RegexParsing::Pattern::Pattern(const std::vector<int> &tokens)
                 return false;
             };
         }
+        charChoiceChars = predChars(charChoicePred);
         return;
     }
 
-    assert(tokens.size() == 1);
+    assert(end - begin == 1);
 
     // check for -'.' (which is also a char choice)
-    if (equalsSpecial(tokens[0], '.')) {
+    if (equalsSpecial(tokens[begin], '.')) {
         DBG << "Dot: literal=.\n";
         type = CharChoice;
         charChoicePred = [](char c) { return c != EOF && c != '\n'; };
+        charChoiceChars = predChars(charChoicePred);
         return;
     }
 
     // check for char
-    DBG << "Char: literal=" << tokensToString(tokens) << "\n";
-    assert(tokens[0] > 0);
+    DBG << "Char: literal=" << range(begin, end) << "\n";
+    assert(tokens[begin] > 0);
     type = Char;
-    literalChar = static_cast<char>(tokens[0]);
+    literalChar = static_cast<char>(tokens[begin]);
 }
 
-auto RegexParsing::toNode(const std::shared_ptr<Pattern> &p)
-    -> std::unique_ptr<lexer::Node>
+auto RegexParsing::charSet(const Pattern &p) -> lexer::CharSet
 {
-    using namespace lexer;
-    DBG << "Creating node from pattern...\n";
-    switch (p->type) {
+    lexer::CharSet chars;
+    if (p.type == Pattern::Char) {
+        chars.set(static_cast<unsigned char>(p.literalChar));
+        return chars;
+    }
+    assert(p.type == Pattern::CharChoice);
+    if (p.charChoiceChars.any()) {
+        return p.charChoiceChars;
+    }
+    return predChars(p.charChoicePred);
+}
+
+// Flattens a chain of alternatives. With groups, an alternative that is a
+// capture group of its own is kept whole.
+static void collectAlternatives(const Pattern &p,
+                                std::vector<const Pattern *> &alternatives,
+                                bool capturing)
+{
+    for (const Pattern *opr : {p.opr1.get(), p.opr2.get()}) {
+        if (opr->type == Pattern::Alternate
+            && (!capturing || opr->captures == 0))
+        {
+            collectAlternatives(*opr, alternatives, capturing);
+        } else {
+            alternatives.push_back(opr);
+        }
+    }
+}
+
+static auto build(lexer::Node &n,
+                  const Pattern &p,
+                  unsigned *nextGroup,
+                  const Budget &budget) -> lexer::Node::Fragment;
+
+// nextGroup is the number of the next capture group, or nullptr if groups
+// are not captured.
+static auto buildPattern(lexer::Node &n,
+                         const Pattern &p,
+                         unsigned *nextGroup,
+                         const Budget &budget) -> lexer::Node::Fragment
+{
+    using lexer::Node;
+    switch (p.type) {
     case Pattern::Char:
         DBG << "toNode: Char\n";
-        return std::make_unique<LiteralNode>(
-            std::make_shared<CharState>(p->literalChar));
+        return n.literal(charSet(p));
     case Pattern::CharChoice:
         DBG << "toNode: CharChoice\n";
-        return std::make_unique<LiteralNode>(
-            std::make_shared<PredState>(p->charChoicePred));
-    case Pattern::Concat:
+        return n.literal(charSet(p));
+    case Pattern::Literal: {
+        DBG << "toNode: Literal\n";
+        Node::Fragment f;
+        for (char c : p.literal) {
+            lexer::CharSet chars;
+            chars.set(static_cast<unsigned char>(c));
+            f = f.entry.empty() ? n.literal(chars)
+                                : n.concat(std::move(f), n.literal(chars));
+        }
+        return f;
+    }
+    case Pattern::Concat: {
         DBG << "toNode: Concat\n";
-        return std::make_unique<ConcatNode>(toNode(p->opr1), toNode(p->opr2));
-    case Pattern::Alternate:
+        Node::Fragment left = build(n, *p.opr1, nextGroup, budget);
+        Node::Fragment right = build(n, *p.opr2, nextGroup, budget);
+        return n.concat(std::move(left), std::move(right));
+    }
+    case Pattern::Alternate: {
         DBG << "toNode: Alternate\n";
-        return std::make_unique<AlternateNode>(toNode(p->opr1),
-                                               toNode(p->opr2));
+        // Chains of alternatives are built in one step, so the entry and exit
+        // lists are only copied once instead of once per level.
+        std::vector<const Pattern *> alternatives;
+        collectAlternatives(p, alternatives, nextGroup != nullptr);
+        std::vector<Node::Fragment> fragments;
+        fragments.reserve(alternatives.size());
+        for (const Pattern *alt : alternatives) {
+            fragments.push_back(build(n, *alt, nextGroup, budget));
+        }
+        return n.alternate(std::move(fragments));
+    }
     case Pattern::Plus:
         DBG << "toNode: Plus\n";
-        return std::make_unique<PlusNode>(toNode(p->opr1));
+        return n.plus(build(n, *p.opr1, nextGroup, budget));
     case Pattern::Star:
         DBG << "toNode: Star\n";
-        return std::make_unique<StarNode>(toNode(p->opr1));
+        return n.star(build(n, *p.opr1, nextGroup, budget));
     case Pattern::Optional:
         DBG << "toNode: Optional\n";
-        return std::make_unique<OptionalNode>(toNode(p->opr1));
+        return n.optional(build(n, *p.opr1, nextGroup, budget));
+    }
+    return {};
+}
+
+static auto buildCaptures(lexer::Node &n,
+                          const Pattern &p,
+                          unsigned *nextGroup,
+                          const Budget &budget) -> lexer::Node::Fragment
+{
+    if (nextGroup == nullptr || p.captures == 0) {
+        return buildPattern(n, p, nextGroup, budget);
     }
-    return nullptr;
+    // Groups are numbered before their contents, which puts them in the
+    // order of their (.
+    unsigned first = *nextGroup;
+    *nextGroup += p.captures;
+    lexer::Node::Fragment f = buildPattern(n, p, nextGroup, budget);
+    for (unsigned g = first; g < first + p.captures; g++) {
+        n.capture(f, g);
+    }
+    return f;
+}
+
+static auto build(lexer::Node &n,
+                  const Pattern &p,
+                  unsigned *nextGroup,
+                  const Budget &budget) -> lexer::Node::Fragment
+{
+    budget.checkTime();
+    lexer::Node::Fragment f = buildCaptures(n, p, nextGroup, budget);
+    budget.checkNfaStates(n.states.size());
+    return f;
+}
+
+auto RegexParsing::toNode(const std::shared_ptr<Pattern> &p)
+    -> std::unique_ptr<lexer::Node>
+{
+    return toNode(p, Budget());
+}
+
+auto RegexParsing::toNode(const std::shared_ptr<Pattern> &p,
+                          const Budget &budget) -> std::unique_ptr<lexer::Node>
+{
+    DBG << "Creating node from pattern...\n";
+    auto n = std::make_unique<lexer::Node>();
+    n->root = build(*n, *p, nullptr, budget);
+    return n;
 }
 
 auto RegexParsing::toNode(const std::string &text)
     -> std::unique_ptr<lexer::Node>
+{
+    return toNode(text, Budget());
+}
+
+auto RegexParsing::toNode(const std::string &text, const Budget &budget)
+    -> std::unique_ptr<lexer::Node>
 {
     DBG << "Converting " << text << " to node\n";
-    std::shared_ptr<Pattern> p = std::make_shared<Pattern>(text);
+    std::shared_ptr<Pattern> p = std::make_shared<Pattern>(text, budget);
     DBG << "Successfully created pattern from " << text << "\n";
-    return toNode(p);
+    std::shared_ptr<Pattern> opt = optimize(p);
+    budget.checkTime();
+    return toNode(opt, budget);
+}
+
+auto RegexParsing::toCapturingNode(const std::string &text)
+    -> std::unique_ptr<lexer::Node>
+{
+    return toCapturingNode(text, Budget());
+}
+
+auto RegexParsing::toCapturingNode(const std::string &text,
+                                   const Budget &budget)
+    -> std::unique_ptr<lexer::Node>
+{
+    DBG << "Converting " << text << " to capturing node\n";
+    Pattern p(text, budget);
+    auto n = std::make_unique<lexer::Node>();
+    unsigned nextGroup = 1;
+    n->root = build(*n, p, &nextGroup, budget);
+    return n;
 }
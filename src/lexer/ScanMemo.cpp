@@ -0,0 +1,74 @@
+#include "lexer/ScanMemo.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+using lexer::ScanMemo;
+
+void ScanMemo::visit(std::string_view key, std::size_t begin, std::size_t end)
+{
+    pending.push_back({pendingKeys.size(), key.size(), begin, end});
+    pendingKeys.append(key);
+}
+
+void ScanMemo::fail()
+{
+    for (const Visit &v : pending) {
+        std::string_view key(pendingKeys.data() + v.key, v.keySize);
+        auto it = dead.find(key);
+        if (it == dead.end()) {
+            it = dead.try_emplace(std::string(key)).first;
+        }
+        // Keep the ranges disjoint by merging the new one with those it
+        // touches.
+        std::map<std::size_t, std::size_t> &ranges = it->second;
+        std::size_t begin = v.begin;
+        std::size_t end = v.end;
+        auto next = ranges.upper_bound(begin);
+        if (next != ranges.begin() && std::prev(next)->second + 1 >= begin) {
+            --next;
+            begin = next->first;
+        }
+        while (next != ranges.end() && next->first <= end + 1) {
+            end = std::max(end, next->second);
+            next = ranges.erase(next);
+        }
+        ranges.emplace(begin, end);
+    }
+    accept();
+}
+
+auto ScanMemo::deadFrom(std::string_view key, std::size_t at) const
+    -> std::size_t
+{
+    auto it = dead.find(key);
+    if (it == dead.end()) {
+        return std::string_view::npos;
+    }
+    auto range = it->second.upper_bound(at);
+    if (range != it->second.begin() && std::prev(range)->second >= at) {
+        return at;
+    }
+    return range == it->second.end() ? std::string_view::npos : range->first;
+}
+
+void ScanMemo::forget(std::size_t offset)
+{
+    for (auto it = dead.begin(); it != dead.end();) {
+        std::map<std::size_t, std::size_t> &ranges = it->second;
+        while (!ranges.empty() && ranges.begin()->second < offset) {
+            ranges.erase(ranges.begin());
+        }
+        it = ranges.empty() ? dead.erase(it) : std::next(it);
+    }
+}
+
+void ScanMemo::clear()
+{
+    pending.clear();
+    pendingKeys.clear();
+    dead.clear();
+}
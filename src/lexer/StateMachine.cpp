@@ -1,7 +1,10 @@
 #include "lexer/StateMachine.hpp"
 
-#include <cassert>
+#include <algorithm>
+#include <cstddef>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "lexer/Node.hpp"
 #include "lexer/State.hpp"
@@ -14,42 +17,67 @@ StateMachine::StateMachine(std::unique_ptr<Node> n)
     static_assert(State::Accept == 1);
     static_assert(State::Reject == 2);
 
-    // Enter
-    states.push_back(std::make_unique<PredState>([](char) { return true; }));
-    states[State::Enter]->id = State::Enter;
-    // Accept
-    states.push_back(std::make_unique<PredState>([](char) { return true; }));
-    states[State::Accept]->id = State::Accept;
-    // Reject
-    states.push_back(std::make_unique<PredState>([](char) { return true; }));
-    states[State::Reject]->id = State::Reject;
-
-    for (const auto &state : n->states) {
-        state->id = states.size();
-        states.push_back(state);
+    for (unsigned e : n->root.entry) {
+        n->addEdge(State::Enter, e);
     }
-    for (const auto &e : n->entry) {
-        states[State::Enter]->addEdge(e);
-    }
-    for (const auto &x : n->exit) {
-        x->addEdge(states[State::Accept]);
-    }
-    for (const auto &state : states) {
-        state->setRejector(states[State::Reject]);
+    for (unsigned x : n->root.exit) {
+        n->addEdge(x, State::Accept);
     }
+    states = std::move(n->states);
 }
 
 // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
 auto StateMachine::transition(int state, char c) const -> int
+{
+    return step(state, c, nullptr);
+}
+
+// NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
+auto StateMachine::transition(int state,
+                              char c,
+                              std::vector<unsigned> &tags) const -> int
+{
+    return step(state, c, &tags);
+}
+
+// NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
+auto StateMachine::step(int state,
+                        char c,
+                        std::vector<unsigned> *tags) const -> int
 {
     if (state == State::Accept || state == State::Reject) {
         return State::Reject;
     }
 
-    std::shared_ptr<State> currState = states.at(state);
-    std::shared_ptr<State> nextState = currState->transition(c);
-    if (nextState == nullptr) {
-        return State::Reject;
+    // Take the first successor that matches c. If there is none, fall through
+    // the first epsilon successor and try again from there. The step limit
+    // guards against epsilon cycles such as the one in (a*)*.
+    const State *curr = &states.at(state);
+    for (std::size_t steps = 0; steps < states.size(); steps++) {
+        for (std::size_t i = 0; i < curr->successors.size(); i++) {
+            unsigned next = curr->successors[i];
+            if (states[next].matches(c)) {
+                if (tags != nullptr && i < curr->successorTags.size()) {
+                    const std::vector<unsigned> &t = curr->successorTags[i];
+                    tags->insert(tags->end(), t.begin(), t.end());
+                }
+                return static_cast<int>(next);
+            }
+        }
+        if (curr->epsilonSuccessors.empty()) {
+            break;
+        }
+        if (tags != nullptr && !curr->epsilonSuccessorTags.empty()) {
+            const std::vector<unsigned> &t = curr->epsilonSuccessorTags[0];
+            tags->insert(tags->end(), t.begin(), t.end());
+        }
+        curr = &states[curr->epsilonSuccessors.front()];
     }
-    return static_cast<int>(nextState->id);
+    return State::Reject;
+}
+
+auto StateMachine::hasTags() const -> bool
+{
+    return std::any_of(states.begin(), states.end(),
+                       [](const State &s) { return s.hasTags(); });
 }
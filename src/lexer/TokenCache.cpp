@@ -0,0 +1,111 @@
+#include "lexer/TokenCache.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using lexer::SpanReader;
+using lexer::TokenSpan;
+
+static constexpr std::string_view magic = "QTK1";
+
+auto lexer::contentHash(std::string_view data, std::uint64_t seed)
+    -> std::uint64_t
+{
+    std::uint64_t hash = seed;
+    for (char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+static void putVarint(std::string &out, std::uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static void putFixed(std::string &out, std::uint64_t value)
+{
+    for (int i = 0; i < 8; i++) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+auto lexer::encodeSpans(const std::vector<TokenSpan> &spans,
+                        std::uint64_t sourceHash,
+                        std::uint64_t lexerHash) -> std::string
+{
+    std::string out(magic);
+    putFixed(out, sourceHash);
+    putFixed(out, lexerHash);
+    putVarint(out, spans.size());
+    std::size_t lastEnd = 0;
+    for (const TokenSpan &span : spans) {
+        putVarint(out, span.begin - lastEnd);
+        putVarint(out, span.end - span.begin);
+        putVarint(out, span.rule);
+        lastEnd = span.end;
+    }
+    return out;
+}
+
+SpanReader::SpanReader(std::string_view data) : data(data)
+{
+    constexpr std::size_t fixedSize = 16;
+    if (data.substr(0, magic.size()) != magic
+        || data.size() < magic.size() + fixedSize)
+    {
+        return;
+    }
+    pos = magic.size();
+    for (std::uint64_t *field : {&source, &lexer}) {
+        for (int i = 0; i < 8; i++) {
+            *field |= static_cast<std::uint64_t>(
+                          static_cast<unsigned char>(data[pos++]))
+                      << (8 * i);
+        }
+    }
+    std::uint64_t n = 0;
+    ok = varint(n);
+    count = static_cast<std::size_t>(n);
+}
+
+auto SpanReader::varint(std::uint64_t &value) -> bool
+{
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && pos < data.size(); shift += 7) {
+        auto byte = static_cast<unsigned char>(data[pos++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+auto SpanReader::next(TokenSpan &span) -> bool
+{
+    if (!ok || read == count) {
+        return false;
+    }
+    std::uint64_t gap = 0;
+    std::uint64_t length = 0;
+    std::uint64_t rule = 0;
+    if (!varint(gap) || !varint(length) || !varint(rule)) {
+        ok = false;
+        return false;
+    }
+    span.begin = lastEnd + static_cast<std::size_t>(gap);
+    span.end = span.begin + static_cast<std::size_t>(length);
+    span.rule = static_cast<unsigned>(rule);
+    lastEnd = span.end;
+    read++;
+    return true;
+}
@@ -0,0 +1,23 @@
+#include "lexer/TokenDelta.hpp"
+
+#include <cstddef>
+#include <vector>
+
+#include "lexer/TokenCache.hpp"
+
+using lexer::TokenDelta;
+
+void TokenDelta::apply(std::vector<TokenSpan> &spans) const
+{
+    auto at = spans.begin() + static_cast<long>(first);
+    at = spans.erase(at, at + static_cast<long>(removed));
+    at = spans.insert(at, inserted.begin(), inserted.end());
+    for (at += static_cast<long>(inserted.size()); at != spans.end(); ++at) {
+        at->begin = static_cast<std::size_t>(static_cast<long>(at->begin) + shift);
+        at->end = static_cast<std::size_t>(static_cast<long>(at->end) + shift);
+        if (at->reach != TokenSpan::unknown) {
+            at->reach =
+                static_cast<std::size_t>(static_cast<long>(at->reach) + shift);
+        }
+    }
+}
@@ -0,0 +1,171 @@
+#include "lexer/TransitionTable.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lexer/ByteScanner.hpp"
+#include "lexer/State.hpp"
+#include "lexer/StateMachine.hpp"
+
+using lexer::TransitionTable;
+
+TransitionTable::TransitionTable(const StateMachine &sm)
+    : stateCount(sm.states.size())
+{
+    // Column b holds the successor of every state on byte b, followed by
+    // the capture tags of each step if the machine has any. Identical
+    // columns are merged into one byte class.
+    bool tagged = sm.hasTags();
+    std::map<std::vector<unsigned>, int> tagListIndex{{{}, 0}};
+    tagLists.emplace_back();
+    std::map<std::vector<int>, unsigned char> columnClass;
+    std::vector<std::vector<int>> columns;
+    std::vector<unsigned> stepTags;
+    for (unsigned b = 0; b < 256; b++) {
+        std::vector<int> column(tagged ? 2 * stateCount : stateCount);
+        for (unsigned s = 0; s < stateCount; s++) {
+            stepTags.clear();
+            column[s] = sm.transition(static_cast<int>(s),
+                                      static_cast<char>(b), stepTags);
+            if (tagged) {
+                auto [it, inserted] = tagListIndex.emplace(
+                    stepTags, static_cast<int>(tagLists.size()));
+                if (inserted) {
+                    tagLists.push_back(stepTags);
+                    for (unsigned slot : stepTags) {
+                        slots = std::max(slots, slot + 1);
+                    }
+                }
+                column[stateCount + s] = it->second;
+            }
+        }
+        auto [it, inserted] = columnClass.emplace(
+            column, static_cast<unsigned char>(columns.size()));
+        if (inserted) {
+            columns.push_back(std::move(column));
+        }
+        byteClass[b] = it->second;
+    }
+
+    classCount = columns.size();
+    next.resize(static_cast<std::size_t>(stateCount) * classCount);
+    for (unsigned k = 0; k < classCount; k++) {
+        for (unsigned s = 0; s < stateCount; s++) {
+            next[s * classCount + k] = columns[k][s];
+        }
+    }
+    if (tagged) {
+        tagList.resize(next.size());
+        for (unsigned k = 0; k < classCount; k++) {
+            for (unsigned s = 0; s < stateCount; s++) {
+                tagList[s * classCount + k] = columns[k][stateCount + s];
+            }
+        }
+    }
+
+    // Record the bytes on which each state steps to itself, so a lexer can
+    // skip over a run of them at once. NUL and 0xFF read as EOF, so they
+    // never extend a run, and neither does a loop that records a capture.
+    loopScanner.assign(stateCount, -1);
+    std::map<std::string, int> scannerIndex;
+    for (unsigned s = State::Reject + 1; s < stateCount; s++) {
+        CharSet loop;
+        for (unsigned b = 1; b < 255; b++) {
+            std::size_t i = s * classCount + byteClass[b];
+            if (next[i] == static_cast<int>(s)
+                && (tagList.empty() || tagList[i] == 0))
+            {
+                loop.set(b);
+            }
+        }
+        if (loop.none()) {
+            continue;
+        }
+        auto [it, inserted] = scannerIndex.emplace(
+            loop.to_string(), static_cast<int>(scanners.size()));
+        if (inserted) {
+            scanners.emplace_back(loop);
+        }
+        loopScanner[s] = it->second;
+    }
+
+    // A state is final if it has an edge to Accept, either directly or
+    // through the epsilon states that transition falls through.
+    finals.assign(stateCount, 0);
+    for (unsigned s = State::Reject + 1; s < stateCount; s++) {
+        const State *curr = &sm.states[s];
+        for (std::size_t steps = 0; steps < stateCount; steps++) {
+            const std::vector<unsigned> &succ = curr->successors;
+            if (std::find(succ.begin(), succ.end(), State::Accept)
+                != succ.end())
+            {
+                finals[s] = 1;
+                break;
+            }
+            if (curr->epsilonSuccessors.empty()) {
+                break;
+            }
+            curr = &sm.states[curr->epsilonSuccessors.front()];
+        }
+    }
+
+    original.resize(stateCount);
+    for (unsigned s = 0; s < stateCount; s++) {
+        original[s] = static_cast<int>(s);
+    }
+}
+
+auto TransitionTable::validOrder(const std::vector<int> &order) const -> bool
+{
+    if (order.size() != stateCount) {
+        return false;
+    }
+    std::vector<bool> seen(stateCount);
+    for (unsigned k = 0; k < stateCount; k++) {
+        int s = order[k];
+        if (s < 0 || s >= static_cast<int>(stateCount) || seen[s]
+            || (k <= State::Reject && s != static_cast<int>(k)))
+        {
+            return false;
+        }
+        seen[s] = true;
+    }
+    return true;
+}
+
+auto TransitionTable::reordered(const std::vector<int> &order) const
+    -> TransitionTable
+{
+    assert(validOrder(order));
+
+    // from[k] is the current number of the state that becomes k.
+    std::vector<int> current(stateCount, -1);
+    for (unsigned s = 0; s < stateCount; s++) {
+        current[original[s]] = static_cast<int>(s);
+    }
+    std::vector<int> from(stateCount);
+    std::vector<int> to(stateCount);
+    for (unsigned k = 0; k < stateCount; k++) {
+        from[k] = current[order[k]];
+        to[from[k]] = static_cast<int>(k);
+    }
+    TransitionTable t = *this;
+    for (unsigned k = 0; k < stateCount; k++) {
+        std::size_t row = static_cast<std::size_t>(from[k]) * classCount;
+        for (unsigned c = 0; c < classCount; c++) {
+            t.next[k * classCount + c] = to[next[row + c]];
+            if (!tagList.empty()) {
+                t.tagList[k * classCount + c] = tagList[row + c];
+            }
+        }
+        t.loopScanner[k] = loopScanner[from[k]];
+        t.finals[k] = finals[from[k]];
+        t.original[k] = original[from[k]];
+    }
+    return t;
+}
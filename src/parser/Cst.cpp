@@ -0,0 +1,86 @@
+#include "parser/Cst.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "parser/Production.hpp"
+#include "parser/Token.hpp"
+
+using parser::Cst;
+
+auto Cst::terminal(std::unique_ptr<Token> token) -> std::uint32_t
+{
+    auto t = static_cast<std::uint32_t>(tokenList.size());
+    tokenList.push_back(std::move(token));
+    nodeList.push_back({Kind::Terminal, none, t, none});
+    return static_cast<std::uint32_t>(nodeList.size() - 1);
+}
+
+auto Cst::nonTerminal(const Production &p,
+                      const std::uint32_t *children,
+                      std::size_t count) -> std::uint32_t
+{
+    auto id = static_cast<std::uint32_t>(prods.size());
+    auto added = prodIndex.emplace(&p, id);
+    if (added.second) {
+        prods.push_back(&p);
+    }
+    for (std::size_t k = 1; k < count; k++) {
+        nodeList[children[k - 1]].next = children[k];
+    }
+    nodeList.push_back({Kind::NonTerminal,
+                        added.first->second,
+                        count > 0 ? children[0] : none,
+                        none});
+    return static_cast<std::uint32_t>(nodeList.size() - 1);
+}
+
+auto parser::operator<<(std::ostream &os, const Cst &cst) -> std::ostream &
+{
+    const std::vector<Cst::Node> &nodes = cst.nodes();
+    std::vector<std::uint32_t> open; // the next child of each open node
+    auto indent = [&] { os << std::string(2 * open.size(), ' '); };
+    // Prints a node's first line, opening it if it has children.
+    auto print = [&](std::uint32_t n) {
+        indent();
+        if (nodes[n].kind == Cst::Kind::Terminal) {
+            os << "Terminal(" << cst.token(n) << ")";
+            return false;
+        }
+        os << cst.production(n) << "[";
+        if (nodes[n].first == Cst::none) {
+            os << "]";
+            return false;
+        }
+        os << "\n";
+        open.push_back(nodes[n].first);
+        return true;
+    };
+
+    if (cst.root() == Cst::none) {
+        return os;
+    }
+    print(cst.root());
+    while (!open.empty()) {
+        std::uint32_t n = open.back();
+        if (n == Cst::none) {
+            open.pop_back();
+            indent();
+            os << "]";
+            if (!open.empty()) {
+                os << "\n";
+            }
+            continue;
+        }
+        open.back() = nodes[n].next;
+        if (!print(n)) {
+            os << "\n";
+        }
+    }
+    return os;
+}
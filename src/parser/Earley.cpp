@@ -0,0 +1,365 @@
+#include "parser/Earley.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "parser/Forest.hpp"
+#include "parser/Grammar.hpp"
+#include "parser/ParseException.hpp"
+#include "parser/Production.hpp"
+#include "parser/Token.hpp"
+
+using parser::Earley;
+using parser::Forest;
+using parser::Grammar;
+using parser::Production;
+using parser::Token;
+
+Earley::Earley(const Production &goal)
+{
+    const Grammar &g = goal.grammar();
+    std::unordered_map<const Production *, std::uint32_t> index;
+    prods.push_back(&goal);
+    index.emplace(&goal, 0);
+    for (std::size_t i = 0; i < prods.size(); i++) {
+        ruleBegin.push_back(static_cast<std::uint32_t>(rules.size()));
+        nullable.push_back(g.nullable(g.row(*prods[i])));
+        for (std::size_t r = 0; r < prods[i]->ruleCount(); r++) {
+            Rule rule = {i, &prods[i]->rule(r), {}};
+            for (const Production::Symbol &symbol : *rule.symbols) {
+                auto *prod = std::get_if<Production *>(&symbol);
+                if (prod == nullptr) {
+                    rule.productions.push_back(none);
+                    continue;
+                }
+                auto id = static_cast<std::uint32_t>(prods.size());
+                auto added = index.emplace(*prod, id);
+                if (added.second) {
+                    prods.push_back(*prod);
+                }
+                rule.productions.push_back(added.first->second);
+            }
+            rules.push_back(std::move(rule));
+        }
+    }
+    ruleBegin.push_back(static_cast<std::uint32_t>(rules.size()));
+}
+
+auto Earley::matches(const Production::Symbol &s, const Token &token) -> bool
+{
+    if (const Token::Id *id = std::get_if<Token::Id>(&s)) {
+        return token.id() == *id;
+    }
+    if (const char *c = std::get_if<char>(&s)) {
+        return token.text.size() == 1 && token.text[0] == *c;
+    }
+    return token.text == std::get<std::string>(s);
+}
+
+auto Earley::add(std::uint32_t set,
+                 std::uint32_t rule,
+                 std::uint32_t dot,
+                 std::uint32_t origin) -> std::uint32_t
+{
+    auto id = static_cast<std::uint32_t>(items.size());
+    auto added = itemIndex.emplace(Key{set, rule, dot, origin}, id);
+    if (added.second) {
+        items.push_back({rule, dot, origin, set});
+    }
+    return added.first->second;
+}
+
+void Earley::link(std::uint32_t item, std::uint32_t pred, bool leo)
+{
+    std::uint64_t key = (std::uint64_t(item) << 33) | (std::uint64_t(pred) << 1)
+                      | static_cast<std::uint64_t>(leo);
+    if (!linked.insert(key).second) {
+        return;
+    }
+    links.push_back({pred, items[item].link, leo});
+    items[item].link = static_cast<std::uint32_t>(links.size() - 1);
+}
+
+// The Leo entry for completing production in set, memoized. The chain it
+// heads is followed iteratively, since the sets of its later entries may
+// never have been asked for. It ends at the goal's own items from set 0,
+// whose completion parse looks for and must not be skipped.
+auto Earley::leo(std::uint32_t set, std::uint32_t production) -> std::uint32_t
+{
+    std::vector<std::pair<Key, std::uint32_t>> path; // entries to make
+    Key key = {set, production, 0, 0};
+    std::uint32_t next = none;
+    while (true) {
+        auto found = leoIndex.find(key);
+        if (found != leoIndex.end()) {
+            next = found->second;
+            break;
+        }
+        auto head = waiting.find(key);
+        std::uint32_t p = head == waiting.end() ? none : head->second;
+        if (p == none || items[p].next != none
+            || items[p].dot + 1 != rules[items[p].rule].symbols->size()) {
+            leoIndex.emplace(key, none);
+            break;
+        }
+        path.emplace_back(key, p);
+        if (items[p].origin == key.a
+            || (rules[items[p].rule].lhs == 0 && items[p].origin == 0)) {
+            break;
+        }
+        key = {items[p].origin,
+               static_cast<std::uint32_t>(rules[items[p].rule].lhs),
+               0,
+               0};
+    }
+
+    for (auto e = path.rbegin(); e != path.rend(); e++) {
+        std::uint32_t top = next == none ? e->second : leos[next].top;
+        leos.push_back({e->second, next, top});
+        next = static_cast<std::uint32_t>(leos.size() - 1);
+        leoIndex.emplace(e->first, next);
+    }
+    return next;
+}
+
+void Earley::process(std::uint32_t set, std::uint32_t item)
+{
+    Item it = items[item];
+    const Rule &r = rules[it.rule];
+    if (it.dot < r.symbols->size()) {
+        std::uint32_t b = r.productions[it.dot];
+        if (b == none) {
+            return; // scanned once the set is done
+        }
+        auto head = waiting.emplace(Key{set, b, 0, 0}, none).first;
+        items[item].next = head->second;
+        head->second = item;
+        if (predicted[b] != set + 1) {
+            predicted[b] = set + 1;
+            for (std::uint32_t rb = ruleBegin[b]; rb < ruleBegin[b + 1]; rb++) {
+                add(set, rb, 0, set);
+            }
+        }
+        if (nullable[b]) {
+            link(add(set, it.rule, it.dot + 1, it.origin), item);
+        }
+        return;
+    }
+
+    auto lhs = static_cast<std::uint32_t>(r.lhs);
+    auto head = complete.emplace(Key{set, lhs, it.origin, 0}, none).first;
+    items[item].next = head->second;
+    head->second = item;
+    if (it.origin == set) {
+        return; // empty, so its waiting items were advanced when predicting
+    }
+
+    std::uint32_t l = leo(it.origin, lhs);
+    if (l != none && leos[l].next != none) {
+        Item top = items[leos[l].top];
+        link(add(set, top.rule, top.dot + 1, top.origin), l, true);
+        return;
+    }
+    auto waiter = waiting.find(Key{it.origin, lhs, 0, 0});
+    if (waiter == waiting.end()) {
+        return;
+    }
+    for (std::uint32_t w = waiter->second; w != none; w = items[w].next) {
+        Item p = items[w];
+        link(add(set, p.rule, p.dot + 1, p.origin), w);
+    }
+}
+
+auto Earley::parse(const std::vector<std::unique_ptr<Token>> &tokens)
+    -> Forest
+{
+    items.clear();
+    links.clear();
+    leos.clear();
+    itemIndex.clear();
+    waiting.clear();
+    complete.clear();
+    leoIndex.clear();
+    linked.clear();
+    predicted.assign(prods.size(), 0);
+
+    auto n = static_cast<std::uint32_t>(tokens.size());
+    for (std::uint32_t r = ruleBegin[0]; r < ruleBegin[1]; r++) {
+        add(0, r, 0, 0);
+    }
+    predicted[0] = 1;
+    std::uint32_t begin = 0;
+    for (std::uint32_t j = 0;; j++) {
+        for (std::uint32_t x = begin; x < items.size(); x++) {
+            process(j, x);
+        }
+        auto end = static_cast<std::uint32_t>(items.size());
+        if (j == n) {
+            break;
+        }
+        for (std::uint32_t x = begin; x < end; x++) {
+            Item it = items[x];
+            const Rule &r = rules[it.rule];
+            if (it.dot < r.symbols->size() && r.productions[it.dot] == none
+                && matches((*r.symbols)[it.dot], *tokens[j])) {
+                link(add(j + 1, it.rule, it.dot + 1, it.origin), x);
+            }
+        }
+        if (items.size() == end) {
+            std::stringstream ss;
+            ss << "Found " << *tokens[j];
+            throw ParseException(j + 1, ss.str());
+        }
+        begin = end;
+    }
+    itemCount = items.size();
+    if (complete.find(Key{n, 0, 0, 0}) == complete.end()) {
+        throw ParseException(n, "Unexpected end of input");
+    }
+    return forest(n);
+}
+
+// Puts back the items a Leo link skipped: each entry's pred advanced over
+// the production completed below it, from the bottom of the chain up to
+// item itself.
+template<typename Visit>
+void Earley::expand(std::uint32_t item, std::uint32_t leo, Visit visit)
+{
+    std::uint32_t set = items[item].set;
+    for (std::uint32_t e = leo; e != none; e = leos[e].next) {
+        std::uint32_t pred = leos[e].pred;
+        Item p = items[pred];
+        std::size_t before = items.size();
+        std::uint32_t v = add(set, p.rule, p.dot + 1, p.origin);
+        if (items.size() > before) {
+            auto lhs = static_cast<std::uint32_t>(rules[p.rule].lhs);
+            auto head = complete.emplace(Key{set, lhs, p.origin, 0}, none);
+            items[v].next = head.first->second;
+            head.first->second = v;
+        }
+        link(v, pred);
+        visit(v);
+    }
+}
+
+auto Earley::forest(std::uint32_t end) -> Forest
+{
+    // Expand the Leo links of the items the parses use.
+    std::vector<bool> seen;
+    std::vector<std::uint32_t> work;
+    auto visit = [&](std::uint32_t x) {
+        if (x >= seen.size()) {
+            seen.resize(items.size());
+        }
+        if (!seen[x]) {
+            seen[x] = true;
+            work.push_back(x);
+        }
+    };
+    for (std::uint32_t c = complete.at(Key{end, 0, 0, 0}); c != none;
+         c = items[c].next) {
+        visit(c);
+    }
+    while (!work.empty()) {
+        std::uint32_t x = work.back();
+        work.pop_back();
+        for (std::uint32_t l = items[x].link; l != none; l = links[l].next) {
+            if (links[l].leo) {
+                std::uint32_t leo = links[l].pred;
+                links[l].leo = false;
+                links[l].pred = none;
+                expand(x, leo, visit);
+            }
+        }
+        for (std::uint32_t l = items[x].link; l != none; l = links[l].next) {
+            std::uint32_t pred = links[l].pred;
+            if (pred == none) {
+                continue;
+            }
+            Item p = items[pred];
+            if (p.dot > 0) {
+                visit(pred);
+            }
+            std::uint32_t b = rules[p.rule].productions[p.dot];
+            if (b == none) {
+                continue;
+            }
+            auto group = complete.find(Key{items[x].set, b, p.set, 0});
+            std::uint32_t c = group == complete.end() ? none : group->second;
+            for (; c != none; c = items[c].next) {
+                visit(c);
+            }
+        }
+    }
+
+    // Then build the forest from the root down.
+    Forest f;
+    std::unordered_map<Key, std::size_t, KeyHash> symbolOf;
+    std::vector<std::size_t> nodeOf(items.size(), Forest::none);
+    std::vector<std::uint32_t> queue;
+    auto itemNode = [&](std::uint32_t x) {
+        if (nodeOf[x] == Forest::none) {
+            const Item &it = items[x];
+            std::size_t lhs = rules[it.rule].lhs;
+            nodeOf[x] = f.itemNodes.size();
+            f.itemNodes.push_back({prods[lhs],
+                                   it.rule - ruleBegin[lhs],
+                                   it.dot,
+                                   it.origin,
+                                   it.set,
+                                   0,
+                                   0});
+            queue.push_back(x);
+        }
+        return nodeOf[x];
+    };
+    auto symbolNode = [&](std::uint32_t b, std::uint32_t start,
+                          std::uint32_t stop) {
+        auto added = symbolOf.emplace(Key{stop, b, start, 0},
+                                      f.symbolNodes.size());
+        if (!added.second) {
+            return added.first->second;
+        }
+        Forest::Symbol s = {b == none ? nullptr : prods[b],
+                            start,
+                            stop,
+                            f.choices.size(),
+                            0};
+        if (b != none) {
+            std::uint32_t c = complete.at(Key{stop, b, start, 0});
+            for (; c != none; c = items[c].next) {
+                f.choices.push_back(itemNode(c));
+                s.count++;
+            }
+        }
+        f.symbolNodes.push_back(s);
+        return added.first->second;
+    };
+
+    symbolNode(0, 0, end);
+    for (std::size_t q = 0; q < queue.size(); q++) {
+        const Item it = items[queue[q]];
+        std::size_t node = nodeOf[queue[q]];
+        f.itemNodes[node].first = f.packedNodes.size();
+        for (std::uint32_t l = it.link; l != none; l = links[l].next) {
+            std::uint32_t pred = links[l].pred;
+            if (pred == none) {
+                continue;
+            }
+            Item p = items[pred];
+            std::size_t left = p.dot > 0 ? itemNode(pred) : Forest::none;
+            std::size_t right = symbolNode(
+                rules[p.rule].productions[p.dot], p.set, it.set);
+            f.packedNodes.push_back({left, right});
+            f.itemNodes[node].count++;
+        }
+    }
+    return f;
+}
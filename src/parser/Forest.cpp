@@ -0,0 +1,216 @@
+#include "parser/Forest.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "parser/Production.hpp"
+#include "parser/Token.hpp"
+
+using parser::Forest;
+
+auto Forest::nodeCount() const -> std::size_t
+{
+    return symbolNodes.size() + itemNodes.size() + packedNodes.size();
+}
+
+template<typename F>
+void Forest::eachChild(std::size_t node, F f) const
+{
+    std::size_t items = symbolNodes.size();
+    std::size_t packs = items + itemNodes.size();
+    if (node < items) {
+        const Symbol &s = symbolNodes[node];
+        for (std::size_t k = 0; k < s.count; k++) {
+            f(items + choices[s.first + k]);
+        }
+    } else if (node < packs) {
+        const Item &i = itemNodes[node - items];
+        for (std::size_t k = 0; k < i.count; k++) {
+            f(packs + i.first + k);
+        }
+    } else {
+        const Packed &p = packedNodes[node - packs];
+        if (p.left != none) {
+            f(items + p.left);
+        }
+        f(p.right);
+    }
+}
+
+// Orders the nodes children first. A packed node is ready once both its
+// children are. With any set, symbol and item nodes are ready once one
+// alternative is, which is recorded in chosen; otherwise once all are, and
+// nodes on a cycle are left out.
+auto Forest::order(bool any, std::vector<std::size_t> *chosen) const
+    -> std::vector<std::size_t>
+{
+    std::size_t n = nodeCount();
+    std::size_t packs = symbolNodes.size() + itemNodes.size();
+    std::vector<std::size_t> waiting(n, 0);
+    std::vector<std::size_t> parentBegin(n + 1, 0);
+    for (std::size_t u = 0; u < n; u++) {
+        eachChild(u, [&](std::size_t c) {
+            parentBegin[c + 1]++;
+            waiting[u]++;
+        });
+        if (any && u < packs) {
+            waiting[u] = std::min<std::size_t>(waiting[u], 1);
+        }
+    }
+    for (std::size_t u = 0; u < n; u++) {
+        parentBegin[u + 1] += parentBegin[u];
+    }
+    std::vector<std::size_t> parents(parentBegin[n]);
+    std::vector<std::size_t> fill(parentBegin.begin(), parentBegin.end() - 1);
+    for (std::size_t u = 0; u < n; u++) {
+        eachChild(u, [&](std::size_t c) { parents[fill[c]++] = u; });
+    }
+
+    std::vector<std::size_t> ready;
+    for (std::size_t u = 0; u < n; u++) {
+        if (waiting[u] == 0) {
+            ready.push_back(u);
+        }
+    }
+    for (std::size_t k = 0; k < ready.size(); k++) {
+        std::size_t u = ready[k];
+        for (std::size_t e = parentBegin[u]; e < parentBegin[u + 1]; e++) {
+            std::size_t p = parents[e];
+            if (waiting[p] > 0 && --waiting[p] == 0) {
+                ready.push_back(p);
+                if (chosen != nullptr) {
+                    (*chosen)[p] = u;
+                }
+            }
+        }
+    }
+    return ready;
+}
+
+auto Forest::ambiguous() const -> bool
+{
+    return std::any_of(symbolNodes.begin(),
+                       symbolNodes.end(),
+                       [](const Symbol &s) { return s.count > 1; })
+        || std::any_of(itemNodes.begin(), itemNodes.end(), [](const Item &i) {
+               return i.count > 1;
+           });
+}
+
+auto Forest::treeCount() const -> unsigned long
+{
+    constexpr unsigned long many = std::numeric_limits<unsigned long>::max();
+    auto add = [](unsigned long a, unsigned long b) {
+        return a > many - b ? many : a + b;
+    };
+    auto times = [](unsigned long a, unsigned long b) {
+        return b != 0 && a > many / b ? many : a * b;
+    };
+
+    std::size_t items = symbolNodes.size();
+    std::size_t packs = items + itemNodes.size();
+    std::vector<unsigned long> count(nodeCount(), 0);
+    std::vector<std::size_t> ordered = order(false, nullptr);
+    if (ordered.size() < nodeCount()) {
+        return many;
+    }
+    for (std::size_t u : ordered) {
+        if (u >= packs) {
+            count[u] = 1;
+            eachChild(u, [&](std::size_t c) {
+                count[u] = times(count[u], count[c]);
+            });
+            continue;
+        }
+        bool leaf = true;
+        eachChild(u, [&](std::size_t c) {
+            count[u] = add(count[u], count[c]);
+            leaf = false;
+        });
+        if (leaf) {
+            count[u] = 1; // a token, or an empty rule
+        }
+    }
+    return count[0];
+}
+
+auto Forest::tree(std::vector<std::unique_ptr<Token>> &tokens) const
+    -> Production::Node
+{
+    using Node = Production::Node;
+    std::size_t items = symbolNodes.size();
+    std::size_t packs = items + itemNodes.size();
+    std::vector<std::size_t> chosen(nodeCount(), none);
+    order(true, &chosen);
+
+    // The symbols of the chosen rule of a production's node.
+    auto rule = [&](std::size_t symbol) {
+        std::vector<std::size_t> symbols;
+        std::size_t item = chosen[symbol] - items;
+        while (itemNodes[item].count > 0) {
+            const Packed &p = packedNodes[chosen[items + item] - packs];
+            symbols.push_back(p.right);
+            if (p.left == none) {
+                break;
+            }
+            item = p.left;
+        }
+        std::reverse(symbols.begin(), symbols.end());
+        return symbols;
+    };
+
+    struct Open {
+        std::vector<std::size_t> symbols;
+        std::size_t next;
+        std::size_t base; // where the rule's children start in nodes
+    };
+    std::vector<Open> open;
+    std::vector<Node> nodes;
+    auto push = [&](std::size_t symbol) {
+        std::vector<std::size_t> symbols = rule(symbol);
+        if (!symbols.empty()) {
+            open.push_back({std::move(symbols), 0, nodes.size()});
+        }
+    };
+
+    push(0);
+    if (open.empty()) {
+        return Epsilon();
+    }
+    while (true) {
+        Open &o = open.back();
+        if (o.next < o.symbols.size()) {
+            const Symbol &s = symbolNodes[o.symbols[o.next++]];
+            if (s.production == nullptr) {
+                nodes.emplace_back(Terminal{std::move(tokens[s.start])});
+            } else {
+                push(o.symbols[o.next - 1]);
+            }
+            continue;
+        }
+
+        Node n;
+        std::size_t count = nodes.size() - o.base;
+        if (count == 1) {
+            n = std::move(nodes.back());
+        } else if (count > 1) {
+            NonTerminal nt;
+            nt.children.assign(std::make_move_iterator(nodes.begin() + o.base),
+                               std::make_move_iterator(nodes.end()));
+            n = std::move(nt);
+        }
+        nodes.resize(o.base);
+        open.pop_back();
+        if (open.empty()) {
+            return n;
+        }
+        if (!std::holds_alternative<Epsilon>(n)) {
+            nodes.push_back(std::move(n));
+        }
+    }
+}
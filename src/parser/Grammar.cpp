@@ -0,0 +1,134 @@
+#include "parser/Grammar.hpp"
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+#include "parser/ParseTable.hpp"
+#include "parser/Production.hpp"
+
+#define DBG                           \
+    if (!parser::Production::debug) { \
+    } else                            \
+        std::cerr
+
+using parser::Grammar;
+using parser::Production;
+
+Grammar::Grammar(const Production &goal)
+{
+    // Every production reachable from the goal.
+    prods.push_back(&goal);
+    rowOf.emplace(&goal, 0);
+    for (std::size_t i = 0; i < prods.size(); i++) {
+        ruleBegin.push_back(symbolRows.size());
+        for (std::size_t r = 0; r < prods[i]->ruleCount(); r++) {
+            std::vector<std::size_t> rows;
+            for (const Symbol &symbol : prods[i]->rule(r)) {
+                auto *prod = std::get_if<Production *>(&symbol);
+                if (prod == nullptr) {
+                    rows.push_back(none);
+                    continue;
+                }
+                auto added = rowOf.emplace(*prod, prods.size());
+                if (added.second) {
+                    prods.push_back(*prod);
+                }
+                rows.push_back(added.first->second);
+            }
+            symbolRows.push_back(std::move(rows));
+        }
+    }
+    sets.resize(prods.size());
+    for (std::size_t i = 0; i < prods.size(); i++) {
+        sets[i].ruleFirst.resize(prods[i]->ruleCount());
+        sets[i].ruleNullable.resize(prods[i]->ruleCount());
+    }
+    sets[0].canEnd = true;
+
+    // The sets only grow, so iterating until none changes terminates even
+    // for recursive grammars.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (std::size_t i = 0; i < prods.size(); i++) {
+            Sets &s = sets[i];
+            for (std::size_t r = 0; r < prods[i]->ruleCount(); r++) {
+                const std::vector<Symbol> &rule = prods[i]->rule(r);
+                std::size_t size = s.ruleFirst[r].size();
+                bool nullable =
+                    addFirst(rule.begin(), rule.end(), s.ruleFirst[r]);
+                changed |= s.ruleFirst[r].size() != size;
+                s.first.insert(s.ruleFirst[r].begin(), s.ruleFirst[r].end());
+                if (nullable && !s.ruleNullable[r]) {
+                    s.ruleNullable[r] = true;
+                    s.nullable = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (std::size_t i = 0; i < prods.size(); i++) {
+            for (std::size_t r = 0; r < prods[i]->ruleCount(); r++) {
+                const std::vector<Symbol> &rule = prods[i]->rule(r);
+                for (std::size_t k = 0; k < rule.size(); k++) {
+                    std::size_t b = symbolRow(i, r, k);
+                    if (b == none) {
+                        continue;
+                    }
+                    Sets &s = sets[b];
+                    std::size_t size = s.follow.size();
+                    bool last =
+                        addFirst(rule.begin() + k + 1, rule.end(), s.follow);
+                    if (last && b != i) {
+                        s.follow.insert(sets[i].follow.begin(),
+                                        sets[i].follow.end());
+                        if (sets[i].canEnd && !s.canEnd) {
+                            s.canEnd = true;
+                            changed = true;
+                        }
+                    }
+                    changed |= s.follow.size() != size;
+                }
+            }
+        }
+    }
+
+    ll1 = std::make_shared<const ParseTable>(*this);
+    for (const ParseTable::Conflict &c : ll1->conflicts()) {
+        DBG << "LL(1) conflict: " << c << "\n";
+    }
+}
+
+auto Grammar::row(const Production &p) const -> std::size_t
+{
+    auto it = rowOf.find(&p);
+    return it == rowOf.end() ? none : it->second;
+}
+
+// Adds the FIRST set of [begin, end) to set, as far as it is known so far.
+// Returns whether the whole sequence is nullable.
+auto Grammar::addFirst(std::vector<Symbol>::const_iterator begin,
+                       std::vector<Symbol>::const_iterator end,
+                       SymbolSet &set) const -> bool
+{
+    for (auto it = begin; it != end; ++it) {
+        if (!std::holds_alternative<Production *>(*it)) {
+            set.insert(*it);
+            return false;
+        }
+        const Sets &s = sets[rowOf.at(std::get<Production *>(*it))];
+        set.insert(s.first.begin(), s.first.end());
+        if (!s.nullable) {
+            return false;
+        }
+    }
+    return true;
+}
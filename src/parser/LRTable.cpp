@@ -0,0 +1,481 @@
+#include "parser/LRTable.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "parser/Grammar.hpp"
+#include "parser/ParseContext.hpp"
+#include "parser/Production.hpp"
+#include "parser/Token.hpp"
+
+using parser::LRTable;
+using parser::Production;
+using parser::Token;
+
+namespace {
+
+using Item = std::pair<std::size_t, std::size_t>; // rule, dot
+
+// A set of terminal columns.
+class Lookahead {
+  public:
+    explicit Lookahead(std::size_t size = 0) : words((size + 63) / 64) {}
+
+    void add(std::size_t i) { words[i / 64] |= std::uint64_t(1) << (i % 64); }
+    void remove(std::size_t i)
+    {
+        words[i / 64] &= ~(std::uint64_t(1) << (i % 64));
+    }
+    auto has(std::size_t i) const -> bool
+    {
+        return (words[i / 64] >> (i % 64)) & 1;
+    }
+    // Returns whether any column was added.
+    auto merge(const Lookahead &other) -> bool
+    {
+        bool changed = false;
+        for (std::size_t w = 0; w < words.size(); w++) {
+            std::uint64_t merged = words[w] | other.words[w];
+            changed |= merged != words[w];
+            words[w] = merged;
+        }
+        return changed;
+    }
+    template<typename F>
+    void each(std::size_t size, F f) const
+    {
+        for (std::size_t i = 0; i < size; i++) {
+            if (has(i)) {
+                f(i);
+            }
+        }
+    }
+
+  private:
+    std::vector<std::uint64_t> words;
+};
+
+// The grammar with every symbol numbered: terminal columns first, then the
+// productions, the last of which is the start S' -> goal. Lookahead sets
+// have one more bit past the terminals, marking lookaheads that propagate
+// from a kernel item.
+struct NumberedGrammar {
+    std::size_t terminals = 0;
+    std::vector<std::vector<std::size_t>> rhs; // by rule
+    std::vector<std::size_t> ruleBegin;        // by nonterminal, plus one
+    std::vector<Lookahead> first;
+    std::vector<bool> nullable;
+
+    auto marker() const -> std::size_t { return terminals; }
+    auto newLookahead() const -> Lookahead { return Lookahead(terminals + 1); }
+
+    // FIRST of the symbols of rule r from dot on, followed by la.
+    auto follow(std::size_t r, std::size_t dot, const Lookahead &la) const
+        -> Lookahead
+    {
+        Lookahead out = newLookahead();
+        for (std::size_t d = dot; d < rhs[r].size(); d++) {
+            std::size_t x = rhs[r][d];
+            if (x < terminals) {
+                out.add(x);
+                return out;
+            }
+            out.merge(first[x - terminals]);
+            if (!nullable[x - terminals]) {
+                return out;
+            }
+        }
+        out.merge(la);
+        return out;
+    }
+
+    // The LR(1) closure of items, lookaheads merged per LR(0) item.
+    auto closure(std::map<Item, Lookahead> items) const
+        -> std::map<Item, Lookahead>
+    {
+        std::vector<Item> work;
+        for (const auto &entry : items) {
+            work.push_back(entry.first);
+        }
+        while (!work.empty()) {
+            auto [r, dot] = work.back();
+            work.pop_back();
+            if (dot == rhs[r].size() || rhs[r][dot] < terminals) {
+                continue;
+            }
+            std::size_t b = rhs[r][dot] - terminals;
+            Lookahead la = follow(r, dot + 1, items.at({r, dot}));
+            for (std::size_t rb = ruleBegin[b]; rb < ruleBegin[b + 1]; rb++) {
+                auto [it, added] = items.try_emplace({rb, 0}, newLookahead());
+                if (it->second.merge(la) || added) {
+                    work.push_back(it->first);
+                }
+            }
+        }
+        return items;
+    }
+};
+
+} // namespace
+
+LRTable::LRTable(const Production &goal)
+{
+    // Every production reachable from goal, numbered in the order found.
+    std::vector<const Production *> prods{&goal};
+    std::unordered_map<const Production *, std::size_t> index{{&goal, 0}};
+    for (std::size_t i = 0; i < prods.size(); i++) {
+        for (std::size_t r = 0; r < prods[i]->ruleCount(); r++) {
+            for (const Symbol &symbol : prods[i]->rule(r)) {
+                auto *prod = std::get_if<Production *>(&symbol);
+                if (prod == nullptr) {
+                    continue;
+                }
+                if (index.emplace(*prod, prods.size()).second) {
+                    prods.push_back(*prod);
+                }
+            }
+        }
+    }
+    columnSymbol.emplace_back();
+    for (const Production *p : prods) {
+        for (std::size_t r = 0; r < p->ruleCount(); r++) {
+            for (const Symbol &symbol : p->rule(r)) {
+                if (!std::holds_alternative<Production *>(symbol)) {
+                    column(symbol);
+                }
+            }
+        }
+    }
+
+    const parser::Grammar &sets = goal.grammar();
+    NumberedGrammar g;
+    g.terminals = columnCount;
+    nonTerminalCount = prods.size();
+    for (std::size_t n = 0; n < prods.size(); n++) {
+        const Production *p = prods[n];
+        g.ruleBegin.push_back(rules.size());
+        for (std::size_t r = 0; r < p->ruleCount(); r++) {
+            std::vector<std::size_t> symbols;
+            for (const Symbol &symbol : p->rule(r)) {
+                auto *prod = std::get_if<Production *>(&symbol);
+                symbols.push_back(prod != nullptr ? columnCount + index[*prod]
+                                                  : column(symbol));
+            }
+            rules.push_back({n, symbols.size(), p, r});
+            g.rhs.push_back(std::move(symbols));
+        }
+        g.first.push_back(g.newLookahead());
+        for (const Symbol &s : sets.first(sets.row(*p))) {
+            g.first.back().add(column(s));
+        }
+        g.nullable.push_back(sets.nullable(sets.row(*p)));
+    }
+    std::size_t start = rules.size();
+    g.ruleBegin.push_back(start);
+    g.ruleBegin.push_back(start + 1);
+    g.rhs.push_back({columnCount}); // the goal is nonterminal 0
+    g.first.push_back(g.first[0]);
+    g.nullable.push_back(g.nullable[0]);
+    rules.push_back({prods.size(), 1, nullptr, 0});
+
+    // The LR(0) states, each known by its kernel items.
+    std::vector<std::vector<Item>> kernels{{{start, 0}}};
+    std::map<std::vector<Item>, std::size_t> stateOf{{kernels[0], 0}};
+    std::vector<std::map<std::size_t, std::size_t>> next; // by symbol
+    for (std::size_t s = 0; s < kernels.size(); s++) {
+        std::map<Item, Lookahead> items;
+        for (const Item &item : kernels[s]) {
+            items.emplace(item, g.newLookahead());
+        }
+        std::map<std::size_t, std::vector<Item>> moved;
+        for (const auto &[item, la] : g.closure(std::move(items))) {
+            auto [r, dot] = item;
+            if (dot < g.rhs[r].size()) {
+                moved[g.rhs[r][dot]].push_back({r, dot + 1});
+            }
+        }
+        next.emplace_back();
+        for (auto &[symbol, kernel] : moved) {
+            auto [it, added] = stateOf.emplace(kernel, kernels.size());
+            if (added) {
+                kernels.push_back(std::move(kernel));
+            }
+            next[s][symbol] = it->second;
+        }
+    }
+
+    // Lookaheads of the kernel items, found by closing each item over the
+    // marker: lookaheads other than the marker are generated where the dot
+    // moves, and the marker means the item's own lookaheads propagate there.
+    std::vector<std::vector<Lookahead>> la(kernels.size());
+    std::vector<std::vector<std::vector<Item>>> propagate(kernels.size());
+    for (std::size_t s = 0; s < kernels.size(); s++) {
+        la[s].assign(kernels[s].size(), g.newLookahead());
+        propagate[s].resize(kernels[s].size());
+    }
+    la[0][0].add(0);
+    for (std::size_t s = 0; s < kernels.size(); s++) {
+        for (std::size_t k = 0; k < kernels[s].size(); k++) {
+            Lookahead marker = g.newLookahead();
+            marker.add(g.marker());
+            for (auto &[item, l] : g.closure({{kernels[s][k], marker}})) {
+                auto [r, dot] = item;
+                if (dot == g.rhs[r].size()) {
+                    continue;
+                }
+                std::size_t to = next[s].at(g.rhs[r][dot]);
+                const std::vector<Item> &kernel = kernels[to];
+                std::size_t kk =
+                    std::lower_bound(kernel.begin(), kernel.end(),
+                                     Item{r, dot + 1})
+                    - kernel.begin();
+                if (l.has(g.marker())) {
+                    propagate[s][k].push_back({to, kk});
+                    l.remove(g.marker());
+                }
+                la[to][kk].merge(l);
+            }
+        }
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (std::size_t s = 0; s < kernels.size(); s++) {
+            for (std::size_t k = 0; k < kernels[s].size(); k++) {
+                for (auto [to, kk] : propagate[s][k]) {
+                    changed |= la[to][kk].merge(la[s][k]);
+                }
+            }
+        }
+    }
+
+    // Fill in the actions, then share rows that came out the same.
+    std::map<std::vector<int>, std::size_t> actionRows;
+    std::map<std::vector<std::size_t>, std::size_t> gotoRows;
+    for (std::size_t s = 0; s < kernels.size(); s++) {
+        std::vector<int> row(columnCount, 0);
+        std::vector<std::size_t> gotoCells(nonTerminalCount, 0);
+        for (auto [symbol, to] : next[s]) {
+            if (symbol < columnCount) {
+                row[symbol] = static_cast<int>(to) + 1;
+            } else {
+                gotoCells[symbol - columnCount] = to;
+            }
+        }
+
+        std::map<Item, Lookahead> items;
+        for (std::size_t k = 0; k < kernels[s].size(); k++) {
+            items.emplace(kernels[s][k], la[s][k]);
+        }
+        int onlyReduce = 0;
+        for (const auto &[item, l] : g.closure(std::move(items))) {
+            auto [r, dot] = item;
+            if (dot < g.rhs[r].size()) {
+                continue;
+            }
+            int reduce = -static_cast<int>(r) - 1;
+            l.each(columnCount, [&](std::size_t t) {
+                int &cell = row[t];
+                if (cell == 0) {
+                    cell = reduce;
+                    return;
+                }
+                std::optional<Symbol> lookahead;
+                if (t != 0) {
+                    lookahead = columnSymbol[t];
+                }
+                found.push_back({s,
+                                 lookahead,
+                                 rules[r].production,
+                                 rules[r].index,
+                                 cell > 0});
+            });
+            onlyReduce = onlyReduce == 0 ? reduce : 1;
+        }
+        // A state that can only reduce by one rule does so whatever the
+        // token, leaving errors to the states after it. The accepting
+        // reduction must still see the end of the input.
+        bool single = onlyReduce < 0
+                   && std::all_of(row.begin(), row.end(), [&](int a) {
+                          return a == 0 || a == onlyReduce;
+                      })
+                   && static_cast<std::size_t>(-onlyReduce - 1) != start;
+        defaultAction.push_back(single ? onlyReduce : 0);
+
+        if (!single) {
+            std::size_t rows = actions.size() / columnCount;
+            auto [it, added] = actionRows.emplace(std::move(row), rows);
+            if (added) {
+                actions.insert(actions.end(), it->first.begin(),
+                               it->first.end());
+            }
+            actionRow.push_back(it->second);
+        } else {
+            actionRow.push_back(0);
+        }
+        std::size_t rows = gotos.size() / nonTerminalCount;
+        auto [it, added] = gotoRows.emplace(std::move(gotoCells), rows);
+        if (added) {
+            gotos.insert(gotos.end(), it->first.begin(), it->first.end());
+        }
+        gotoRow.push_back(it->second);
+    }
+}
+
+// A char and a one byte string match the same tokens, so they share a
+// column.
+auto LRTable::column(const Symbol &s) -> std::size_t
+{
+    if (const Token::Id *id = std::get_if<Token::Id>(&s)) {
+        if (static_cast<std::size_t>(*id) >= idColumn.size()) {
+            idColumn.resize(*id + 1, -1);
+        }
+        if (idColumn[*id] < 0) {
+            idColumn[*id] = static_cast<int>(columnCount++);
+            columnSymbol.push_back(s);
+        }
+        return idColumn[*id];
+    }
+
+    std::string text = std::holds_alternative<char>(s)
+                           ? std::string(1, std::get<char>(s))
+                           : std::get<std::string>(s);
+    auto [it, added] = textColumn.emplace(std::move(text), columnCount);
+    if (added) {
+        columnCount++;
+        columnSymbol.push_back(s);
+    }
+    return it->second;
+}
+
+// A token in both a text column and a Token::Id column takes the action of
+// its text, the more specific of the two.
+auto LRTable::action(std::size_t state, const Token *token) const -> int
+{
+    const int *row = &actions[actionRow[state] * columnCount];
+    if (token == nullptr) {
+        return row[0];
+    }
+    if (!textColumn.empty()) {
+        auto it = textColumn.find(token->text);
+        if (it != textColumn.end() && row[it->second] != 0) {
+            return row[it->second];
+        }
+    }
+    Token::Id id = token->id();
+    if (id >= 0 && static_cast<std::size_t>(id) < idColumn.size()
+        && idColumn[id] >= 0)
+    {
+        return row[idColumn[id]];
+    }
+    return 0;
+}
+
+void LRTable::fail(const ParseContext &ctx, std::size_t state) const
+{
+    std::stringstream ss;
+    ss << "Expected one of";
+    const int *row = &actions[actionRow[state] * columnCount];
+    for (std::size_t t = 0; t < columnCount; t++) {
+        if (row[t] == 0) {
+            continue;
+        }
+        ss << " ";
+        if (t == 0) {
+            ss << "end of input";
+        } else {
+            ss << columnSymbol[t];
+        }
+    }
+    ctx.error(ss.str());
+}
+
+auto LRTable::parse(std::vector<std::unique_ptr<Token>> &tokens) const -> Node
+{
+    ParseContext ctx(tokens);
+    return parse(ctx);
+}
+
+auto LRTable::parse(ParseContext &ctx) const -> Node
+{
+    std::vector<std::size_t> states{0};
+    std::vector<Node> nodes;
+    while (true) {
+        std::size_t state = states.back();
+        int a = defaultAction[state];
+        if (a == 0) {
+            a = action(state, ctx.token.get());
+        }
+        if (a == 0) {
+            fail(ctx, state);
+        }
+        if (a > 0) {
+            nodes.emplace_back(Terminal{ctx.eat()});
+            states.push_back(static_cast<std::size_t>(a - 1));
+            continue;
+        }
+
+        // Replace the rule's symbols with the node they make.
+        const Rule &rule = rules[-a - 1];
+        std::size_t base = nodes.size() - rule.length;
+        auto empty = [](const Node &n) {
+            return std::holds_alternative<Epsilon>(n);
+        };
+        std::size_t count = rule.length
+                          - std::count_if(nodes.begin() + base, nodes.end(),
+                                          empty);
+        Node n;
+        if (count == 1) {
+            n = std::move(*std::find_if_not(nodes.begin() + base,
+                                            nodes.end(),
+                                            empty));
+        } else if (count > 1) {
+            NonTerminal nt;
+            nt.children.reserve(count);
+            for (auto it = nodes.begin() + base; it != nodes.end(); ++it) {
+                if (!empty(*it)) {
+                    nt.children.push_back(std::move(*it));
+                }
+            }
+            n = std::move(nt);
+        }
+        nodes.resize(base);
+        states.resize(states.size() - rule.length);
+        if (rule.production == nullptr) {
+            return n;
+        }
+        states.push_back(
+            gotos[gotoRow[states.back()] * nonTerminalCount + rule.lhs]);
+        nodes.push_back(std::move(n));
+    }
+}
+
+auto parser::operator<<(std::ostream &os,
+                        const LRTable::Conflict &c) -> std::ostream &
+{
+    os << "state " << c.state << " on ";
+    if (c.lookahead) {
+        os << *c.lookahead;
+    } else {
+        os << "end of input";
+    }
+    os << ": " << (c.shift ? "shift" : "an earlier reduction")
+       << " over reducing ";
+    if (c.production != nullptr) {
+        os << *c.production << " by rule " << c.rule;
+    } else {
+        os << "the goal";
+    }
+    return os;
+}
@@ -0,0 +1,254 @@
+#include "parser/Packrat.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "parser/ParseException.hpp"
+#include "parser/Production.hpp"
+#include "parser/Token.hpp"
+
+using parser::Packrat;
+using parser::Production;
+using parser::Token;
+
+Packrat::Packrat(const Production &goal, std::size_t memoSize)
+{
+    prods.push_back(&goal);
+    index.emplace(&goal, 0);
+    for (std::size_t i = 0; i < prods.size(); i++) {
+        for (std::size_t r = 0; r < prods[i]->ruleCount(); r++) {
+            for (const Production::Symbol &symbol : prods[i]->rule(r)) {
+                auto *prod = std::get_if<Production *>(&symbol);
+                if (prod == nullptr) {
+                    continue;
+                }
+                if (index.emplace(*prod, prods.size()).second) {
+                    prods.push_back(*prod);
+                }
+            }
+        }
+    }
+    active.resize(prods.size());
+
+    std::size_t size = 1;
+    while (size < memoSize) {
+        size *= 2;
+    }
+    memo.resize(size);
+}
+
+auto Packrat::find(std::size_t production, std::size_t pos) -> const Entry *
+{
+    const Entry &e =
+        memo[(pos * prods.size() + production) & (memo.size() - 1)];
+    if (e.production != production || e.pos != pos) {
+        return nullptr;
+    }
+    hits++;
+    return &e;
+}
+
+void Packrat::store(const Entry &e)
+{
+    Entry &slot =
+        memo[(e.pos * prods.size() + e.production) & (memo.size() - 1)];
+    evictions += slot.production != none;
+    slot = e;
+}
+
+auto Packrat::matches(const Production::Symbol &s, std::size_t pos) -> bool
+{
+    if (pos == tokens->size()) {
+        furthest = pos;
+        return false;
+    }
+    const Token &token = *(*tokens)[pos];
+    bool match;
+    if (const Token::Id *id = std::get_if<Token::Id>(&s)) {
+        match = token.id() == *id;
+    } else if (const char *c = std::get_if<char>(&s)) {
+        match = token.text.size() == 1 && token.text[0] == *c;
+    } else {
+        match = token.text == std::get<std::string>(s);
+    }
+    if (!match && pos > furthest) {
+        furthest = pos;
+    }
+    return match;
+}
+
+// Matches a production at pos with an explicit stack of the rules being
+// tried, storing the result of every production it finishes.
+auto Packrat::match(std::size_t production, std::size_t pos) -> Entry
+{
+    if (const Entry *e = find(production, pos)) {
+        return *e;
+    }
+    auto retry = [this](Frame &f) {
+        f.rule++;
+        f.symbol = 0;
+        f.pos = f.start;
+        pending.resize(f.kids);
+    };
+    frames.push_back({production, pos, 0, 0, pos, pending.size()});
+    active[production].push_back(pos);
+
+    while (true) {
+        Frame &f = frames.back();
+        const Production &p = *prods[f.production];
+        if (f.rule < p.ruleCount() && f.symbol < p.rule(f.rule).size()) {
+            const Production::Symbol &symbol = p.rule(f.rule)[f.symbol];
+            auto *prod = std::get_if<Production *>(&symbol);
+            if (prod == nullptr) {
+                if (matches(symbol, f.pos)) {
+                    f.symbol++;
+                    f.pos++;
+                } else {
+                    retry(f);
+                }
+                continue;
+            }
+
+            std::size_t q = index.at(*prod);
+            if (const Entry *e = find(q, f.pos)) {
+                if (e->step == none) {
+                    retry(f);
+                } else {
+                    pending.push_back(e->step);
+                    f.symbol++;
+                    f.pos = e->end;
+                }
+            } else if (!active[q].empty() && active[q].back() == f.pos) {
+                retry(f); // left recursion
+            } else {
+                active[q].push_back(f.pos);
+                frames.push_back({q, f.pos, 0, 0, f.pos, pending.size()});
+            }
+            continue;
+        }
+
+        // Every rule failed, or the current one matched.
+        Entry result = {static_cast<std::uint32_t>(f.production),
+                        static_cast<std::uint32_t>(f.start),
+                        static_cast<std::uint32_t>(f.start),
+                        none};
+        if (f.rule < p.ruleCount()) {
+            result.end = static_cast<std::uint32_t>(f.pos);
+            result.step = static_cast<std::uint32_t>(steps.size());
+            steps.push_back({static_cast<std::uint32_t>(f.production),
+                             static_cast<std::uint32_t>(f.rule),
+                             static_cast<std::uint32_t>(kids.size())});
+            kids.insert(kids.end(), pending.begin() + f.kids, pending.end());
+            pending.resize(f.kids);
+        }
+        store(result);
+        active[f.production].pop_back();
+        frames.pop_back();
+        if (frames.empty()) {
+            return result;
+        }
+
+        Frame &parent = frames.back();
+        if (result.step == none) {
+            retry(parent);
+        } else {
+            pending.push_back(result.step);
+            parent.symbol++;
+            parent.pos = result.end;
+        }
+    }
+}
+
+auto Packrat::parse(std::vector<std::unique_ptr<Token>> &input) -> Node
+{
+    tokens = &input;
+    furthest = 0;
+    hits = 0;
+    evictions = 0;
+    for (Entry &e : memo) {
+        e = Entry();
+    }
+    steps.clear();
+    kids.clear();
+
+    Entry goal = match(0, 0);
+    if (goal.step == none || goal.end != input.size()) {
+        std::size_t at = goal.step == none ? furthest : goal.end;
+        std::stringstream ss;
+        if (at < input.size()) {
+            ss << "Found " << *input[at];
+        } else {
+            ss << "Unexpected end of input";
+        }
+        if (goal.step != none) {
+            ss << ": Expected end of input";
+        }
+        throw ParseException(static_cast<unsigned>(at + 1), ss.str());
+    }
+    return build(input, goal.step, 0);
+}
+
+// Builds the tree of a step as produce would, taking its tokens from input.
+auto Packrat::build(std::vector<std::unique_ptr<Token>> &input,
+                    std::uint32_t step,
+                    std::size_t pos) -> Node
+{
+    struct Open {
+        const Step *step;
+        std::size_t symbol;
+        std::size_t kid;
+        std::size_t base; // where the rule's children start in nodes
+    };
+    std::vector<Open> open;
+    std::vector<Node> nodes;
+    auto push = [&](const Step &s) {
+        if (prods[s.production]->rule(s.rule).empty()) {
+            return false;
+        }
+        open.push_back({&s, 0, s.kids, nodes.size()});
+        return true;
+    };
+
+    if (!push(steps[step])) {
+        return Epsilon();
+    }
+    while (true) {
+        Open &o = open.back();
+        const std::vector<Production::Symbol> &rule =
+            prods[o.step->production]->rule(o.step->rule);
+        if (o.symbol < rule.size()) {
+            if (!std::holds_alternative<Production *>(rule[o.symbol++])) {
+                nodes.emplace_back(Terminal{std::move(input[pos++])});
+            } else {
+                push(steps[kids[o.kid++]]);
+            }
+            continue;
+        }
+
+        Node n;
+        std::size_t count = nodes.size() - o.base;
+        if (count == 1) {
+            n = std::move(nodes.back());
+        } else if (count > 1) {
+            NonTerminal nt;
+            nt.children.assign(std::make_move_iterator(nodes.begin() + o.base),
+                               std::make_move_iterator(nodes.end()));
+            n = std::move(nt);
+        }
+        nodes.resize(o.base);
+        open.pop_back();
+        if (open.empty()) {
+            return n;
+        }
+        if (!std::holds_alternative<Epsilon>(n)) {
+            nodes.push_back(std::move(n));
+        }
+    }
+}
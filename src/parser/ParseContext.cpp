@@ -29,6 +29,11 @@ auto ParseContext::eatGeneric(bool tokenIsValid,
     return nullptr;
 }
 
+auto ParseContext::eat() -> std::unique_ptr<Token>
+{
+    return eatGeneric(token != nullptr);
+}
+
 auto ParseContext::eat(Token::Id t) -> std::unique_ptr<Token>
 {
     return eatGeneric(token && token->id() == t,
@@ -63,8 +68,13 @@ void ParseContext::error(const std::string &msg) const
 
 auto ParseContext::nextToken() -> std::unique_ptr<Token>
 {
-    if (i == tokens.size()) {
+    if (tokens == nullptr) {
+        std::unique_ptr<Token> next = source();
+        i += next != nullptr;
+        return next;
+    }
+    if (i == tokens->size()) {
         return nullptr;
     }
-    return std::move(tokens[i++]);
+    return std::move((*tokens)[i++]);
 }
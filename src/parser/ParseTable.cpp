@@ -0,0 +1,132 @@
+#include "parser/ParseTable.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "parser/Grammar.hpp"
+#include "parser/Production.hpp"
+#include "parser/Token.hpp"
+
+using parser::ParseTable;
+using parser::Production;
+using parser::Token;
+
+ParseTable::ParseTable(const Grammar &g)
+{
+    const std::vector<const Production *> &rows = g.rows();
+    // Every lookahead a rule can be predicted on is in some FIRST or FOLLOW
+    // set. Numbering them all first lets the cells be one dense array.
+    for (std::size_t row = 0; row < rows.size(); row++) {
+        for (const Symbol &s : g.first(row)) {
+            column(s);
+        }
+        for (const Symbol &s : g.follow(row)) {
+            column(s);
+        }
+    }
+    cells.assign(rows.size() * columnCount, -1);
+    fallback.assign(rows.size(), -1);
+
+    for (std::size_t row = 0; row < rows.size(); row++) {
+        for (std::size_t r = 0; r < rows[row]->ruleCount(); r++) {
+            for (const Symbol &s : g.ruleFirst(row, r)) {
+                predict(rows, row, column(s), s, r);
+            }
+            if (!g.ruleNullable(row, r)) {
+                continue;
+            }
+            for (const Symbol &s : g.follow(row)) {
+                predict(rows, row, column(s), s, r);
+            }
+            if (g.canEnd(row)) {
+                predict(rows, row, 0, std::nullopt, r);
+            }
+            if (fallback[row] < 0) {
+                fallback[row] = static_cast<int>(r);
+            }
+        }
+    }
+}
+
+auto ParseTable::rule(std::size_t row, const Token *token) const -> int
+{
+    const int *cell = &cells[row * columnCount];
+    if (token == nullptr) {
+        return cell[0] >= 0 ? cell[0] : fallback[row];
+    }
+
+    int r = -1;
+    Token::Id id = token->id();
+    if (id >= 0 && static_cast<std::size_t>(id) < idColumn.size()
+        && idColumn[id] >= 0)
+    {
+        r = cell[idColumn[id]];
+    }
+    if (!textColumn.empty()) {
+        auto it = textColumn.find(token->text);
+        if (it != textColumn.end()) {
+            int t = cell[it->second];
+            if (t >= 0 && (r < 0 || t < r)) {
+                r = t;
+            }
+        }
+    }
+    return r >= 0 ? r : fallback[row];
+}
+
+// A char and a one byte string match the same tokens, so they share a
+// column.
+auto ParseTable::column(const Symbol &s) -> std::size_t
+{
+    if (const Token::Id *id = std::get_if<Token::Id>(&s)) {
+        if (static_cast<std::size_t>(*id) >= idColumn.size()) {
+            idColumn.resize(*id + 1, -1);
+        }
+        if (idColumn[*id] < 0) {
+            idColumn[*id] = static_cast<int>(columnCount++);
+        }
+        return idColumn[*id];
+    }
+
+    std::string text = std::holds_alternative<char>(s)
+                           ? std::string(1, std::get<char>(s))
+                           : std::get<std::string>(s);
+    auto [it, added] = textColumn.emplace(std::move(text), columnCount);
+    columnCount += added;
+    return it->second;
+}
+
+void ParseTable::predict(const std::vector<const Production *> &rows,
+                         std::size_t row,
+                         std::size_t col,
+                         std::optional<Symbol> lookahead,
+                         std::size_t rule)
+{
+    int &cell = cells[row * columnCount + col];
+    if (cell < 0) {
+        cell = static_cast<int>(rule);
+    } else if (static_cast<std::size_t>(cell) != rule) {
+        found.push_back({rows[row],
+                         std::move(lookahead),
+                         static_cast<std::size_t>(cell),
+                         rule});
+    }
+}
+
+auto parser::operator<<(std::ostream &os,
+                        const ParseTable::Conflict &c) -> std::ostream &
+{
+    os << *c.production << ": rules " << c.rule << " and " << c.other
+       << " both expand on ";
+    if (c.lookahead) {
+        os << *c.lookahead;
+    } else {
+        os << "end of input";
+    }
+    return os;
+}
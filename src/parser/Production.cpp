@@ -0,0 +1,359 @@
+#include "parser/Production.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "parser/Cst.hpp"
+#include "parser/Grammar.hpp"
+#include "parser/IndentedStream.hpp"
+#include "parser/ParseContext.hpp"
+#include "parser/ParseTable.hpp"
+#include "parser/Token.hpp"
+
+bool parser::Production::debug = false;
+#define DBG                   \
+    if (!Production::debug) { \
+    } else                    \
+        std::cerr
+
+using Symbol = parser::Production::Symbol;
+using SymbolSet = std::unordered_set<Symbol>;
+
+void parser::Production::add(std::initializer_list<Symbol> symbols)
+{
+    if (frozen) {
+        throw std::logic_error("rule added to production " + name +
+                               " after a grammar using it was built");
+    }
+    rules.emplace_back(symbols.begin(), symbols.end());
+}
+
+auto parser::Production::grammar() const -> const Grammar &
+{
+    std::call_once(built, [this] {
+        sets = std::make_shared<Grammar>(*this);
+        for (const Production *p : sets->rows()) {
+            p->frozen = true;
+        }
+    });
+    return *sets;
+}
+
+void parser::Production::finalize() const
+{
+    grammar();
+}
+
+auto parser::Production::nullable() const -> bool
+{
+    return grammar().nullable(0);
+}
+
+auto parser::Production::first() const -> const SymbolSet &
+{
+    return grammar().first(0);
+}
+
+auto parser::Production::ruleFirst(std::size_t r) const -> const SymbolSet &
+{
+    return grammar().ruleFirst(0, r);
+}
+
+auto parser::Production::ruleNullable(std::size_t r) const -> bool
+{
+    return grammar().ruleNullable(0, r);
+}
+
+auto parser::Production::table() const -> const ParseTable &
+{
+    return grammar().table();
+}
+
+auto parser::Production::produce(std::vector<std::unique_ptr<Token>> &tokens)
+    -> parser::Production::Node
+{
+    ParseContext ctx(tokens);
+    return produce(ctx, true);
+}
+
+parser::NonTerminal::~NonTerminal()
+{
+    using Node = Production::Node;
+    auto nested = [](const Node &n) {
+        const NonTerminal *nt = std::get_if<NonTerminal>(&n);
+        return nt != nullptr && !nt->children.empty();
+    };
+    if (std::none_of(children.begin(), children.end(), nested)) {
+        return;
+    }
+
+    // Detach the children of nested nodes before they are destroyed, so
+    // that each destructor only sees an empty list.
+    std::vector<std::vector<Node>> pending;
+    pending.push_back(std::move(children));
+    while (!pending.empty()) {
+        std::vector<Node> nodes = std::move(pending.back());
+        pending.pop_back();
+        for (Node &n : nodes) {
+            if (nested(n)) {
+                pending.push_back(std::move(std::get<NonTerminal>(n).children));
+            }
+        }
+    }
+}
+
+static auto eatTerminal(const Symbol &symbol, parser::ParseContext &ctx)
+    -> std::unique_ptr<parser::Token>
+{
+    using parser::Token;
+    if (std::holds_alternative<Token::Id>(symbol)) {
+        return ctx.eat(std::get<Token::Id>(symbol));
+    }
+    if (std::holds_alternative<char>(symbol)) {
+        return ctx.eat(std::get<char>(symbol));
+    }
+    return ctx.eat(std::get<std::string>(symbol));
+}
+
+static void trace(std::size_t depth,
+                  const parser::Production &p,
+                  const std::vector<Symbol> *rule)
+{
+    IndentedStream ios(std::cerr, static_cast<int>(depth) * 4);
+    ios << "Producing " << p << "\n";
+    if (rule == nullptr) {
+        return;
+    }
+    if (rule->empty()) {
+        ios << "(epsilon)\n";
+    } else {
+        ios << "Chosen rule: " << *rule << "\n";
+    }
+}
+
+static void checkGoal(parser::ParseContext &ctx, bool isGoal)
+{
+    if (isGoal && ctx.token) {
+        ctx.error("Expected end of input");
+    }
+}
+
+namespace {
+
+// Builds the nodes produce returns. A rule's node is its only child, or a
+// NonTerminal of its children; productions that matched nothing are left
+// out.
+struct NodeBuilder {
+    using Node = parser::Production::Node;
+
+    std::vector<Node> nodes;
+    std::vector<std::size_t> bases; // where each open rule's children start
+    Node result;
+
+    void open(const parser::Production &) { bases.push_back(nodes.size()); }
+    void terminal(std::unique_ptr<parser::Token> token)
+    {
+        nodes.emplace_back(parser::Terminal{std::move(token)});
+    }
+    void close(const parser::Production &)
+    {
+        Node n;
+        std::size_t base = bases.back();
+        std::size_t count = nodes.size() - base;
+        if (count == 1) {
+            n = std::move(nodes.back());
+        } else if (count > 1) {
+            parser::NonTerminal nt;
+            nt.children.assign(std::make_move_iterator(nodes.begin() + base),
+                               std::make_move_iterator(nodes.end()));
+            n = std::move(nt);
+        }
+        nodes.resize(base);
+        bases.pop_back();
+        if (bases.empty()) {
+            result = std::move(n);
+        } else if (!std::holds_alternative<parser::Epsilon>(n)) {
+            nodes.push_back(std::move(n));
+        }
+    }
+};
+
+// Builds a Cst, keeping the roots of the open rules' children on a stack.
+struct CstBuilder {
+    parser::Cst cst;
+    std::vector<std::uint32_t> roots;
+    std::vector<std::size_t> bases;
+
+    void open(const parser::Production &) { bases.push_back(roots.size()); }
+    void terminal(std::unique_ptr<parser::Token> token)
+    {
+        roots.push_back(cst.terminal(std::move(token)));
+    }
+    void close(const parser::Production &p)
+    {
+        std::size_t base = bases.back();
+        std::uint32_t n =
+            cst.nonTerminal(p, roots.data() + base, roots.size() - base);
+        roots.resize(base);
+        roots.push_back(n);
+        bases.pop_back();
+    }
+};
+
+} // namespace
+
+// Expands nonterminals from an explicit stack instead of recursing, so the
+// nesting of the input is limited only by memory. Every rule chosen is
+// opened and closed on build, with its terminals passed in between.
+template<typename Builder>
+void parser::Production::derive(ParseContext &ctx,
+                                bool isGoal,
+                                Builder &build)
+{
+    struct Frame {
+        std::size_t row; // of the production in g
+        const std::vector<Symbol> *rule;
+        std::size_t r;
+        std::size_t next; // the symbol to match next
+    };
+    std::vector<Frame> frames;
+    const Grammar &g = grammar();
+
+    auto expand = [&](std::size_t row) {
+        const Production &p = *g.rows()[row];
+        int r = g.table().rule(row, ctx.token.get());
+        const std::vector<Symbol> *rule = r >= 0 ? &p.rules[r] : nullptr;
+        if (debug) {
+            trace(frames.size(), p, rule);
+        }
+        if (rule == nullptr) {
+            std::stringstream ss;
+            ss << "No rule in " << p << " that matches token";
+            ctx.error(ss.str());
+        }
+        frames.push_back({row, rule, static_cast<std::size_t>(r), 0});
+        build.open(p);
+    };
+
+    expand(0);
+    while (true) {
+        Frame &f = frames.back();
+        if (f.next < f.rule->size()) {
+            std::size_t k = f.next++;
+            std::size_t row = g.symbolRow(f.row, f.r, k);
+            if (row != Grammar::none) {
+                expand(row);
+            } else {
+                build.terminal(eatTerminal((*f.rule)[k], ctx));
+            }
+            continue;
+        }
+
+        build.close(*g.rows()[f.row]);
+        frames.pop_back();
+        if (frames.empty()) {
+            checkGoal(ctx, isGoal);
+            return;
+        }
+    }
+}
+
+auto parser::Production::produce(ParseContext &ctx,
+                                 bool isGoal) -> parser::Production::Node
+{
+    NodeBuilder build;
+    derive(ctx, isGoal, build);
+    return std::move(build.result);
+}
+
+auto parser::Production::produceCst(
+    std::vector<std::unique_ptr<Token>> &tokens) -> parser::Cst
+{
+    ParseContext ctx(tokens);
+    return produceCst(ctx, true);
+}
+
+auto parser::Production::produceCst(ParseContext &ctx, bool isGoal)
+    -> parser::Cst
+{
+    CstBuilder build;
+    derive(ctx, isGoal, build);
+    return std::move(build.cst);
+}
+
+auto parser::operator<<(std::ostream &os,
+                        const parser::Production &p) -> std::ostream &
+{
+    if (!p.name.empty()) {
+        os << "Production(" << p.name << ")";
+        return os;
+    }
+
+    os << "Production[\n";
+    IndentedStream ios2(os, 2);
+    for (const std::vector<Production::Symbol> &rule : p.rules) {
+        ios2 << rule << "\n";
+    }
+    os << "]";
+    return os;
+}
+
+auto parser::operator<<(std::ostream &os,
+                        const std::vector<parser::Production::Symbol> &rule)
+    -> std::ostream &
+{
+    os << "Rule[\n";
+    IndentedStream ios(os);
+    for (const Production::Symbol &s : rule) {
+        ios << s << "\n";
+    }
+    os << "]";
+    return os;
+}
+
+auto parser::operator<<(std::ostream &os,
+                        const parser::Production::Symbol &s) -> std::ostream &
+{
+    os << "Symbol(";
+    if (std::holds_alternative<Production *>(s)) {
+        os << *std::get<Production *>(s);
+    } else if (std::holds_alternative<Token::Id>(s)) {
+        os << "Token::Id " << std::get<Token::Id>(s);
+    } else if (std::holds_alternative<char>(s)) {
+        os << '\'' << std::get<char>(s) << '\'';
+    } else if (std::holds_alternative<std::string>(s)) {
+        os << '\"' << std::get<std::string>(s) << '\"';
+    }
+    os << ")";
+    return os;
+}
+auto parser::operator<<(std::ostream &os,
+                        const Production::Node &n) -> std::ostream &
+{
+    if (std::holds_alternative<Epsilon>(n)) {
+        os << "Epsilon()";
+    } else if (std::holds_alternative<Terminal>(n)) {
+        os << "Terminal(" << *std::get<Terminal>(n).literal << ")";
+    } else if (std::holds_alternative<NonTerminal>(n)) {
+        os << "NonTerminal[\n";
+        IndentedStream ios(os);
+        for (const Production::Node &node : std::get<NonTerminal>(n).children) {
+            ios << node << "\n";
+        }
+        os << "]";
+    }
+    return os;
+}
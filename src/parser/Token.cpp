@@ -1,13 +1,20 @@
 #include "parser/Token.hpp"
 
+#include <atomic>
 #include <ostream>
 
 using parser::Token;
 
+static std::atomic<Token::Id> tokenIdCount = 0;
+
 auto Token::newTokenId() -> Token::Id
 {
-    static Id tokenId = 0;
-    return ++tokenId;
+    return tokenIdCount++;
+}
+
+auto Token::idCount() -> Token::Id
+{
+    return tokenIdCount;
 }
 
 auto parser::operator<<(std::ostream &o, const Token &t) -> std::ostream &
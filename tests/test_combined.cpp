@@ -1,10 +1,14 @@
+#include <cstddef>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "lexer/Lexer.hpp"
+#include "lexer/TokenStream.hpp"
 #include "parser/Production.hpp"
 #include "parser/Token.hpp"
 
@@ -44,3 +48,140 @@ TEST(TestCombined, IfElse)
     vector<unique_ptr<Token>> tokens = lexer.tokenize(ss);
     std::cout << g.produce(tokens) << "\n";
 }
+
+struct NumToken : public Token {
+    NumToken(std::string text) : Token(std::move(text)) {}
+};
+
+// A token type written for the old virtual id() hides the stamped one.
+struct OldToken : public Token {
+    OldToken(std::string text) : Token(std::move(text)) {}
+    auto id() -> Id { return 7; }
+};
+static_assert(KeepsTokenId<Token, NumToken>::value);
+static_assert(!KeepsTokenId<Token, OldToken>::value);
+
+// Checks the terminals down the right spine of an items list, one for each
+// rule the table chose, against the token ids each rule expects.
+static void
+expectItems(const Production::Node &n,
+            const std::vector<std::pair<std::string, Token::Id>> &items)
+{
+    const Production::Node *node = &n;
+    for (std::size_t i = 0; i < items.size(); i++) {
+        const Production::Node *item = node;
+        if (i + 1 < items.size()) {
+            ASSERT_TRUE(std::holds_alternative<NonTerminal>(*node));
+            const auto &children = std::get<NonTerminal>(*node).children;
+            ASSERT_EQ(children.size(), 2);
+            item = &children[0];
+            node = &children[1];
+        }
+        ASSERT_TRUE(std::holds_alternative<Terminal>(*item));
+        const Token &token = *std::get<Terminal>(*item).literal;
+        EXPECT_EQ(token.text, items[i].first);
+        EXPECT_EQ(token.id(), items[i].second);
+    }
+}
+
+TEST(TestCombined, TokenIds)
+{
+    Lexer<Token> lexer;
+    lexer.opts.ignoreWhitespace = true;
+    lexer.addTokenType<NumToken>("[0-9]+");
+    lexer.addTokenType("[a-z]+");
+
+    Production g("g");
+    Production items("items");
+    g.add({&items});
+    items.add({Token::id<NumToken>(), &items});
+    items.add({Token::id<Token>(), &items});
+    items.add({});
+
+    std::stringstream ss;
+    ss << "abc 12 de 3";
+    vector<unique_ptr<Token>> tokens = lexer.tokenize(ss);
+    ASSERT_EQ(tokens.size(), 4);
+    EXPECT_EQ(tokens[0]->id(), Token::id<Token>());
+    EXPECT_EQ(tokens[1]->id(), Token::id<NumToken>());
+    expectItems(g.produce(tokens),
+                {{"abc", Token::id<Token>()},
+                 {"12", Token::id<NumToken>()},
+                 {"de", Token::id<Token>()},
+                 {"3", Token::id<NumToken>()}});
+}
+
+TEST(TestCombined, CachedTokens)
+{
+    Lexer<Token> lexer;
+    lexer.opts.ignoreWhitespace = true;
+    lexer.addTokenType<NumToken>("[0-9]+");
+    lexer.addTokenType("[a-z]+");
+    CompiledLexer<Token> compiled = lexer.compile();
+
+    Production g("g");
+    Production items("items");
+    g.add({&items});
+    items.add({Token::id<NumToken>(), &items});
+    items.add({Token::id<Token>(), &items});
+    items.add({});
+
+    std::string source = "abc 12 de 3";
+    std::string data = compiled.cache(source);
+
+    // A later run parses straight from the cached stream, to the same tree
+    // as from freshly lexed tokens.
+    TokenStream<Token> stream(compiled, source, data);
+    ASSERT_TRUE(stream.valid());
+    ParseContext ctx([&stream]() { return stream.next(); });
+    std::stringstream cached;
+    cached << g.produce(ctx, true);
+    EXPECT_EQ(ctx.i, 4);
+    EXPECT_EQ(ctx.token, nullptr);
+    vector<unique_ptr<Token>> tokens = compiled.tokenize(source);
+    std::stringstream lexed;
+    lexed << g.produce(tokens);
+    EXPECT_EQ(cached.str(), lexed.str());
+}
+
+TEST(TestCombined, DeepNesting)
+{
+    Lexer<Token> lexer;
+    lexer.addTokenType("s");
+    lexer.addTokenType("{");
+    lexer.addTokenType("}");
+
+    Production s("s");
+    Production s1("s1");
+    Production l("l");
+    Production l1("l1");
+    s.add({'s'});
+    s.add({'{', &s1});
+    s1.add({&l, '}'});
+    s1.add({'}'});
+    l.add({&s, &l1});
+    l1.add({&l});
+    l1.add({});
+
+    // Far deeper than the native stack allows one call per nonterminal.
+    constexpr std::size_t depth = 20000;
+    std::stringstream ss;
+    ss << std::string(depth, '{') << std::string(depth, '}');
+    vector<unique_ptr<Token>> tokens = lexer.tokenize(ss);
+    Production::Node n = s.produce(tokens);
+
+    // Each level is S -> { S1, S1 -> S }, and the innermost S1 is just }.
+    std::size_t levels = 0;
+    const Production::Node *node = &n;
+    while (node != nullptr) {
+        levels++;
+        const NonTerminal &nt = std::get<NonTerminal>(*node);
+        node = nullptr;
+        for (const Production::Node &child : nt.children) {
+            if (std::holds_alternative<NonTerminal>(child)) {
+                node = &child;
+            }
+        }
+    }
+    EXPECT_EQ(levels, 2 * depth - 1);
+}
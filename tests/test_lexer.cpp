@@ -1,13 +1,19 @@
+#include <algorithm>
 #include <cctype>
+#include <cstdint>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <typeinfo>
 #include <utility>
 #include <vector>
 
 #include "lexer/Lexer.hpp"
+#include "lexer/StaticLexer.hpp"
+#include "lexer/TokenStream.hpp"
 
 using namespace lexer;
 
@@ -70,3 +76,773 @@ TEST(TestLexer, Literals)
         std::cout << *token << "\n";
     }
 }
+
+TEST(TestLexer, Stats)
+{
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType<DecimalToken>(R"( [0-9]+ )");
+    l.addTokenType(R"( [a-z]+ )");
+
+    std::stringstream ss;
+    ss << "12 abc 345";
+    std::vector<std::unique_ptr<Token>> tokens = l.tokenize(ss);
+    ASSERT_EQ(tokens.size(), 3);
+
+    ASSERT_EQ(l.stats.rules.size(), 3);
+    EXPECT_GT(l.stats.rules[0].states, 0);
+    EXPECT_EQ(l.stats.rules[0].pattern, R"( [0-9]+ )");
+    if constexpr (statsEnabled) {
+        EXPECT_EQ(l.stats.rules[0].tokens, 2);
+        EXPECT_EQ(l.stats.rules[0].bytes, 5);
+        EXPECT_EQ(l.stats.rules[1].tokens, 1);
+        EXPECT_EQ(l.stats.rules[2].tokens, 2);
+        EXPECT_GT(l.stats.averageActive(), 0);
+    }
+    std::string json = l.stats.toJson();
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_NE(json.find("\"rules\":["), std::string::npos);
+}
+
+TEST(TestLexer, StatsMerge)
+{
+    // Independent of QLANG_LEXER_STATS, which only controls the counting.
+    LexerStats total;
+    total.rules = {{"[a-z]+", 2, 1, 2}}; // labelled before a rule moved
+    total.steps = 4;
+    total.activeMachines = 4;
+
+    LexerStats session;
+    session.rules = {{"[0-9]+", 3, 2, 5}, {R"("x")", 2, 1, 1}};
+    session.steps = 6;
+    session.activeMachines = 12;
+    session.rollbacks = 1;
+    session.elapsed = std::chrono::nanoseconds(7);
+
+    total.merge(session);
+    ASSERT_EQ(total.rules.size(), 2);
+    EXPECT_EQ(total.rules[0].pattern, "[0-9]+");
+    EXPECT_EQ(total.rules[0].states, 3);
+    EXPECT_EQ(total.rules[0].tokens, 3);
+    EXPECT_EQ(total.rules[0].bytes, 7);
+    EXPECT_EQ(total.rules[1].pattern, R"("x")");
+    EXPECT_EQ(total.rules[1].states, 2);
+    EXPECT_EQ(total.steps, 10);
+    EXPECT_EQ(total.rollbacks, 1);
+    EXPECT_DOUBLE_EQ(total.averageActive(), 1.6);
+
+    EXPECT_EQ(total.toJson(),
+              R"({"steps":10,"activeMachines":16,"averageActive":1.6,)"
+              R"("rollbacks":1,"elapsedNs":7,"rules":[)"
+              R"({"index":0,"pattern":"[0-9]+","states":3,"tokens":3,)"
+              R"("bytes":7},)"
+              R"({"index":1,"pattern":"\"x\"","states":2,"tokens":1,)"
+              R"("bytes":1}]})");
+    std::stringstream ss;
+    ss << total;
+    EXPECT_EQ(ss.str(),
+              "LexerStats(steps=10, avgActive=1.6, rollbacks=1, "
+              "elapsedNs=7)\n"
+              "  [0] [0-9]+: states=3 tokens=3 bytes=7\n"
+              "  [1] \"x\": states=2 tokens=1 bytes=1\n");
+
+    total.clearCounters();
+    EXPECT_EQ(total.rules[0].tokens, 0);
+    EXPECT_EQ(total.rules[0].pattern, "[0-9]+");
+    EXPECT_EQ(total.steps, 0);
+    EXPECT_EQ(total.elapsed.count(), 0);
+}
+
+TEST(TestLexer, RepeatedTokenize)
+{
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType<DecimalToken>(R"( [0-9]+ )");
+
+    for (int i = 0; i < 3; i++) {
+        std::stringstream ss;
+        ss << "1 22\n333";
+        EXPECT_EQ(l.tokenize(ss).size(), 3);
+        EXPECT_EQ(l.stats.rules.size(), 2);
+    }
+}
+
+TEST(TestLexer, SharedCompiledLexer)
+{
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType<DecimalToken>(R"( [0-9]+ )");
+    l.addTokenType<HexToken>(R"( 0x[0-9a-fA-F]+ )");
+    const CompiledLexer<Token> compiled = l.compile();
+
+    std::string text;
+    for (int i = 0; i < 200; i++) {
+        text += std::to_string(i) + " 0x" + std::to_string(i) + "\n";
+    }
+
+    std::vector<std::thread> workers;
+    std::vector<std::size_t> counts(4);
+    for (std::size_t t = 0; t < counts.size(); t++) {
+        workers.emplace_back([&compiled, &text, &counts, t]() {
+            LexSession<Token> session(compiled);
+            for (int i = 0; i < 10; i++) {
+                counts[t] = session.tokenize(text).size();
+            }
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    for (std::size_t count : counts) {
+        EXPECT_EQ(count, 400);
+    }
+}
+
+static constexpr char decRegex[] = R"( [0-9]+ )";
+static constexpr char hexRegex[] = R"( 0x[0-9a-fA-F]+ )";
+static constexpr char wsRegex[] = R"( [ \n]+ )";
+
+TEST(TestLexer, StaticLexer)
+{
+    StaticLexer<Token,
+                Rule<DecimalToken, decRegex>,
+                Rule<HexToken, hexRegex>,
+                Rule<void, wsRegex>>
+        sl;
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType<DecimalToken>(decRegex);
+    l.addTokenType<HexToken>(hexRegex);
+
+    const std::string text = "12 0x1f\n  7 0xAB 0";
+    std::stringstream ss(text);
+    std::vector<std::unique_ptr<Token>> expected = l.tokenize(ss);
+    std::vector<std::unique_ptr<Token>> tokens = sl.tokenize(text);
+    ASSERT_EQ(tokens.size(), expected.size());
+    for (std::size_t i = 0; i < tokens.size(); i++) {
+        std::stringstream a;
+        std::stringstream b;
+        a << *tokens[i];
+        b << *expected[i];
+        EXPECT_EQ(a.str(), b.str());
+    }
+    EXPECT_THROW(sl.tokenize("12 $"), LexException);
+}
+
+TEST(TestLexer, OrderedAlternatives)
+{
+    // A rule takes the first alternative that matches each byte, so "ab" and
+    // "abc" are never reached, with or without a capture group around them.
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType(R"( "a"|"ab"|"abc" )");
+    Lexer<Token> captured;
+    captured.opts.ignoreWhitespace = true;
+    captured.addTokenType(R"( ("a"|"ab"|"abc") )",
+                          [](const std::string &text, const Captures &) {
+                              return std::make_unique<Token>(text);
+                          });
+
+    for (Lexer<Token> *lexer : {&l, &captured}) {
+        std::stringstream ss;
+        ss << "a a";
+        std::vector<std::unique_ptr<Token>> tokens = lexer->tokenize(ss);
+        ASSERT_EQ(tokens.size(), 2);
+        EXPECT_EQ(tokens[0]->text, "a");
+        EXPECT_EQ(tokens[1]->text, "a");
+        std::stringstream abc;
+        abc << "abc";
+        EXPECT_THROW(lexer->tokenize(abc), LexException);
+    }
+}
+
+static constexpr char floatRegex[] = R"( [0-9]+\.[0-9]+ )";
+static constexpr char dotRegex[] = R"( "."("..")? )";
+static constexpr char aRegex[] = R"( "a" )";
+static constexpr char aStarBRegex[] = R"( a*b )";
+
+TEST(TestLexer, MaximalMunch)
+{
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType(floatRegex);
+    l.addTokenType(decRegex);
+    l.addTokenType(dotRegex);
+    l.addTokenType(R"( "=" )");
+    l.addTokenType(R"( ([a-z]+)(=[0-9]+)? )",
+                   [](const std::string &text, const Captures &captures) {
+                       return std::make_unique<Token>(
+                           std::string(captures.view(text, 1)) + "/" + text);
+                   });
+    CompiledLexer<Token> compiled = l.compile();
+
+    // Longer candidates that die part way fall back to the last token that
+    // matched: 1 before ". ", ab before "= " and . before "..".
+    using Texts = std::vector<std::string>;
+    auto texts = [](const std::vector<std::unique_ptr<Token>> &tokens) {
+        Texts result;
+        for (const auto &t : tokens) {
+            result.push_back(t->text);
+        }
+        return result;
+    };
+    std::string text = "1. 1.5 2.x 1.. ab= cd=4 ... 7.";
+    Texts expected = {"1",     ".", "1.5",     "2",   ".", "x/x", "1", ".",
+                      ".",     "ab/ab", "=", "cd/cd=4", "...", "7", "."};
+    EXPECT_EQ(texts(compiled.tokenize(text)), expected);
+    std::stringstream ss(text);
+    EXPECT_EQ(texts(compiled.tokenize(ss)), expected);
+    EXPECT_EQ(compiled.scan(text).size(), expected.size());
+
+    LexSession<Token> session(compiled);
+    std::vector<std::unique_ptr<Token>> fed;
+    for (char c : text) {
+        for (auto &t : session.feed(std::string_view(&c, 1))) {
+            fed.push_back(std::move(t));
+        }
+    }
+    for (auto &t : session.finish()) {
+        fed.push_back(std::move(t));
+    }
+    EXPECT_EQ(texts(fed), expected);
+
+    StaticLexer<Token,
+                Rule<Token, floatRegex>,
+                Rule<Token, decRegex>,
+                Rule<Token, dotRegex>,
+                Rule<void, wsRegex>>
+        sl;
+    EXPECT_EQ(texts(sl.tokenize("1. 1.5 1..")),
+              (Texts{"1", ".", "1.5", "1", ".", "."}));
+
+    // Nothing to fall back to.
+    EXPECT_THROW(compiled.tokenize("$"), LexException);
+
+    // Every token but the last is found by looking to the end of the input
+    // and falling back, which would take quadratic time without the memo.
+    Lexer<Token> adversarial;
+    adversarial.addTokenType(aRegex);
+    adversarial.addTokenType(aStarBRegex);
+    CompiledLexer<Token> ab = adversarial.compile();
+    LexSession<Token> abSession(ab);
+    std::string as(200000, 'a');
+    ASSERT_EQ(abSession.tokenize(as).size(), as.size());
+    if constexpr (statsEnabled) {
+        EXPECT_EQ(abSession.stats.rollbacks, as.size() - 1);
+        EXPECT_LT(abSession.stats.steps, 4 * as.size());
+    }
+    StaticLexer<Token, Rule<Token, aRegex>, Rule<Token, aStarBRegex>> sab;
+    EXPECT_EQ(sab.tokenize(as).size(), as.size());
+    EXPECT_EQ(sab.tokenize(as + "b").size(), 1);
+
+    // Streams are read a chunk at a time, so tokens and rollbacks cross
+    // chunk boundaries; the tokens and the location must not depend on it.
+    std::string many;
+    while (many.size() < 20000) {
+        many += text + (many.size() % 3 ? " " : "\n");
+    }
+    LexSession<Token> whole(compiled);
+    LexSession<Token> streamed(compiled);
+    std::stringstream manyStream(many);
+    EXPECT_EQ(texts(streamed.tokenize(manyStream)),
+              texts(whole.tokenize(many)));
+    EXPECT_EQ(streamed.location().line, whole.location().line);
+    EXPECT_EQ(streamed.location().col, whole.location().col);
+    std::stringstream asStream(as + "b" + as);
+    EXPECT_EQ(abSession.tokenize(asStream).size(), 1 + as.size());
+
+    std::string dots;
+    while (dots.size() < 20000) {
+        dots += "1. 1.5 1..\n";
+    }
+    std::stringstream dotStream(dots);
+    EXPECT_EQ(texts(sl.tokenize(dotStream)), texts(sl.tokenize(dots)));
+    std::stringstream sabStream(as + "b" + as);
+    EXPECT_EQ(sab.tokenize(sabStream).size(), 1 + as.size());
+
+    // An error past the first chunk is reported where it is.
+    std::stringstream bad(dots + "$");
+    try {
+        sl.tokenize(bad);
+        FAIL() << "expected a LexException";
+    } catch (const LexException &e) {
+        std::string at = "line " + std::to_string(20000 / 11 + 2) + " col 1";
+        EXPECT_NE(std::string(e.what()).find(at), std::string::npos)
+            << e.what();
+    }
+}
+
+TEST(TestLexer, SelfLoopRuns)
+{
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType(R"( [a-zA-Z_][a-zA-Z0-9_]* )");
+    l.addTokenType(R"( \"([^"\\\n]|\\.)*\" )");
+    l.addTokenType(R"( "=" )");
+
+    // Runs longer than one 16-byte block, ending mid-block and at the end.
+    std::string ident(37, 'x');
+    std::string body(50, 'y');
+    std::string text = ident + " = \"" + body + "\\\"z\"\n\n   " + ident + "_1";
+    std::stringstream ss(text);
+    std::vector<std::unique_ptr<Token>> expected = l.tokenize(ss);
+
+    CompiledLexer<Token> compiled = l.compile();
+    LexSession<Token> session(compiled);
+    std::vector<std::unique_ptr<Token>> tokens = session.tokenize(text);
+    ASSERT_EQ(tokens.size(), 4);
+    ASSERT_EQ(tokens.size(), expected.size());
+    for (std::size_t i = 0; i < tokens.size(); i++) {
+        EXPECT_EQ(tokens[i]->text, expected[i]->text);
+    }
+    EXPECT_EQ(tokens[2]->text, "\"" + body + "\\\"z\"");
+    EXPECT_EQ(session.location().line, 3);
+    EXPECT_EQ(session.location().col, 3 + ident.size() + 2);
+
+    // The run must stop at the byte that leaves the class.
+    EXPECT_THROW(session.tokenize(ident + "\"" + body + "\n\""), LexException);
+}
+
+struct StringToken : Token {
+    std::string body;
+    StringToken(const std::string &text, const Captures &captures)
+        : Token(text), body(captures.view(text, 1))
+    {}
+};
+
+TEST(TestLexer, Captures)
+{
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType<StringToken>(R"( \"(([^"\\\n]|\\.)*)\" )");
+    l.addTokenType(R"( 0x([0-9a-fA-F]+) )",
+                   [](const std::string &text, const Captures &captures) {
+                       EXPECT_EQ(captures.begin(1), 2);
+                       EXPECT_EQ(captures.end(1), text.size());
+                       return std::make_unique<Token>(
+                           std::string(captures.view(text, 1)));
+                   });
+    std::vector<std::string> floats;
+    l.addTokenType(R"( ([0-9]+)(\.([0-9]*))? )",
+                   [&](const std::string &text, const Captures &captures) {
+                       EXPECT_EQ(captures.size(), 4);
+                       floats.push_back(std::string(captures.view(text, 1)) + "|"
+                                        + std::string(captures.view(text, 3)));
+                       EXPECT_EQ(captures.matched(2), captures.matched(3));
+                       return std::make_unique<Token>(text);
+                   });
+
+    std::stringstream ss;
+    ss << R"("ab\"c" 0x1F 12.50 7 "")";
+    std::vector<std::unique_ptr<Token>> tokens = l.tokenize(ss);
+    ASSERT_EQ(tokens.size(), 5);
+    EXPECT_EQ(dynamic_cast<StringToken &>(*tokens[0]).body, R"(ab\"c)");
+    EXPECT_EQ(tokens[1]->text, "1F");
+    EXPECT_EQ(dynamic_cast<StringToken &>(*tokens[4]).body, "");
+    ASSERT_EQ(floats.size(), 2);
+    EXPECT_EQ(floats[0], "12|50");
+    EXPECT_EQ(floats[1], "7|");
+
+    // A repeated group keeps its last iteration.
+    Lexer<Token> rep;
+    rep.addTokenType(R"( x(ab)+ )",
+                     [](const std::string &text, const Captures &captures) {
+                         return std::make_unique<Token>(
+                             std::string(captures.view(text, 1)));
+                     });
+    std::stringstream rs;
+    rs << "xababab";
+    tokens = rep.tokenize(rs);
+    ASSERT_EQ(tokens.size(), 1);
+    EXPECT_EQ(tokens[0]->text, "ab");
+}
+
+TEST(TestLexer, ProfiledLayout)
+{
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType(R"( "let"|"if"|"in"|"for"|"return" )");
+    l.addTokenType(R"( [a-zA-Z_][a-zA-Z0-9_]* )");
+    l.addTokenType(R"( [0-9]+ )");
+    l.addTokenType(R"( "="|"+"|";" )");
+
+    const std::string sample = "let x = y + 1;\nfor i in items return i;\n";
+    std::stringstream before(sample);
+    std::vector<std::unique_ptr<Token>> expected = l.tokenize(before);
+
+    l.profile(sample);
+    ASSERT_EQ(l.layout.size(), 5);
+    for (const std::vector<int> &order : l.layout) {
+        ASSERT_GE(order.size(), 3);
+        EXPECT_EQ(order[0], State::Enter);
+        EXPECT_EQ(order[1], State::Accept);
+        EXPECT_EQ(order[2], State::Reject);
+    }
+
+    std::stringstream after(sample);
+    std::vector<std::unique_ptr<Token>> tokens = l.tokenize(after);
+    ASSERT_EQ(tokens.size(), expected.size());
+    for (std::size_t i = 0; i < tokens.size(); i++) {
+        EXPECT_EQ(tokens[i]->text, expected[i]->text);
+    }
+
+    // A saved layout can be applied to a fresh compile; entries that do not
+    // fit their rule are ignored.
+    CompiledLexer<Token> compiled = l.compile();
+    EXPECT_EQ(compiled.layout(), l.layout);
+    CompiledLexer<Token>::Layout bad = l.layout;
+    bad[0].pop_back();
+    EXPECT_EQ(compiled.withLayout(bad).layout(), compiled.layout());
+    EXPECT_EQ(compiled.tokenize("if let1 = 22;").size(), 5);
+
+    // A layout restored into a lexer that already tokenized is applied by
+    // its next tokenize, and clearing it restores the original order.
+    Lexer<Token> restored;
+    restored.opts.ignoreWhitespace = true;
+    restored.addTokenType(R"( "let"|"if"|"in"|"for"|"return" )");
+    restored.addTokenType(R"( [a-zA-Z_][a-zA-Z0-9_]* )");
+    restored.addTokenType(R"( [0-9]+ )");
+    restored.addTokenType(R"( "="|"+"|";" )");
+    std::stringstream first(sample);
+    EXPECT_EQ(restored.tokenize(first).size(), expected.size());
+    CompiledLexer<Token>::Layout plain = restored.compiledLexer().layout();
+    EXPECT_NE(plain, l.layout);
+    restored.layout = l.layout;
+    std::stringstream second(sample);
+    EXPECT_EQ(restored.tokenize(second).size(), expected.size());
+    EXPECT_EQ(restored.compiledLexer().layout(), l.layout);
+    restored.layout.clear();
+    EXPECT_EQ(restored.compiledLexer().layout(), plain);
+}
+
+TEST(TestLexer, Batch)
+{
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType(R"( [a-zA-Z_][a-zA-Z0-9_]* )");
+    l.addTokenType(R"( [0-9]+ )");
+    l.addTokenType(R"( \"([^"\\\n]|\\.)*\" )");
+    l.addTokenType(R"( "="|":" )");
+    CompiledLexer<Token> compiled = l.compile();
+
+    std::vector<std::string> lines;
+    for (int i = 0; i < 50; i++) {
+        lines.push_back("level=" + std::to_string(i % 3) + " msg=\"request "
+                        + std::to_string(i) + "\" user" + std::to_string(i));
+        if (i % 7 == 0) {
+            lines.emplace_back();
+        }
+    }
+    std::vector<std::string_view> records(lines.begin(), lines.end());
+
+    LexSession<Token> session(compiled);
+    TokenBatch<Token> batch;
+    for (int round = 0; round < 2; round++) {
+        session.tokenizeBatch(records, batch);
+        ASSERT_EQ(batch.size(), records.size());
+        for (std::size_t r = 0; r < records.size(); r++) {
+            std::vector<std::unique_ptr<Token>> expected =
+                compiled.tokenize(records[r]);
+            ASSERT_EQ(batch.count(r), expected.size()) << records[r];
+            for (std::size_t i = 0; i < expected.size(); i++) {
+                EXPECT_EQ(batch.token(r, i).text, expected[i]->text);
+            }
+        }
+    }
+
+    records.push_back("ok=1\nbad=$");
+    try {
+        session.tokenizeBatch(records, batch);
+        FAIL() << "expected a LexException";
+    } catch (const LexException &e) {
+        EXPECT_NE(std::string(e.what()).find("line 2 col 5"), std::string::npos)
+            << e.what();
+    }
+
+    // Tokens of the records a throw cut short are not carried over.
+    records = {"aaa bbb $", "x"};
+    EXPECT_THROW(session.tokenizeBatch(records, batch), LexException);
+    records = {"q", "r"};
+    session.tokenizeBatch(records, batch);
+    ASSERT_EQ(batch.size(), 2);
+    ASSERT_EQ(batch.count(0), 1);
+    EXPECT_EQ(batch.token(0, 0).text, "q");
+    ASSERT_EQ(batch.count(1), 1);
+    EXPECT_EQ(batch.token(1, 0).text, "r");
+}
+
+TEST(TestLexer, PushMode)
+{
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType(R"( [a-zA-Z_][a-zA-Z0-9_]* )");
+    l.addTokenType(R"( [0-9]+ )");
+    l.addTokenType(R"( \"([^"\\\n]|\\.)*\" )");
+    l.addTokenType(R"( "="|"=="|";" )");
+    CompiledLexer<Token> compiled = l.compile();
+
+    std::string text = "alpha = 12345;\nmsg == \"a long string split "
+                       "over chunks\"; identifier_that_is_long = 7";
+    std::vector<std::unique_ptr<Token>> expected = compiled.tokenize(text);
+
+    LexSession<Token> session(compiled);
+    for (std::size_t size = 1; size <= 8; size++) {
+        std::vector<std::unique_ptr<Token>> tokens;
+        for (std::size_t pos = 0; pos < text.size(); pos += size) {
+            std::string_view chunk = std::string_view(text).substr(pos, size);
+            for (auto &t : session.feed(chunk)) {
+                tokens.push_back(std::move(t));
+            }
+        }
+        for (auto &t : session.finish()) {
+            tokens.push_back(std::move(t));
+        }
+        ASSERT_EQ(tokens.size(), expected.size()) << "chunk size " << size;
+        for (std::size_t i = 0; i < expected.size(); i++) {
+            EXPECT_EQ(tokens[i]->text, expected[i]->text);
+        }
+    }
+
+    // Tokens are handed out as soon as a later byte ends them.
+    EXPECT_TRUE(session.feed("abc").empty());
+    EXPECT_EQ(session.feed(" 1").size(), 1);
+    EXPECT_EQ(session.finish().size(), 1);
+    EXPECT_TRUE(session.finish().empty());
+
+    session.feed("x = 1;\ny = ");
+    try {
+        session.feed("$");
+        FAIL() << "expected a LexException";
+    } catch (const LexException &e) {
+        EXPECT_NE(std::string(e.what()).find("line 2 col 5"), std::string::npos)
+            << e.what();
+    }
+    session.feed("\"open");
+    EXPECT_THROW(session.finish(), LexException);
+    EXPECT_EQ(session.feed("ok").size(), 0);
+    EXPECT_EQ(session.finish().size(), 1);
+}
+
+TEST(TestLexer, RuntimeRules)
+{
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType(R"( [a-z]+ )");
+    l.addTokenType(R"( "<"|"=" )");
+
+    auto texts = [&l](const std::string &text) {
+        std::stringstream ss(text);
+        std::vector<std::string> result;
+        for (const auto &t : l.tokenize(ss)) {
+            result.push_back(t->text);
+        }
+        return result;
+    };
+    using Texts = std::vector<std::string>;
+    EXPECT_EQ(texts("a <= b"), (Texts{"a", "<", "=", "b"}));
+    EXPECT_EQ(l.stats.rules.size(), 3);
+
+    // Added after the compile, but still before the whitespace rule. A
+    // lexer compiled before keeps its rules.
+    CompiledLexer<Token> before = l.compile();
+    l.addTokenType(R"( "<="">"? )");
+    EXPECT_EQ(texts("a <= b <=> c"), (Texts{"a", "<=", "b", "<=>", "c"}));
+    EXPECT_EQ(before.rules().size(), 3);
+    EXPECT_EQ(before.tokenize("a <= b").size(), 4);
+    ASSERT_EQ(l.stats.rules.size(), 4);
+    EXPECT_EQ(l.stats.rules[2].pattern, R"( "<="">"? )");
+
+    EXPECT_TRUE(l.removeTokenType(R"( "<="">"? )"));
+    EXPECT_FALSE(l.removeTokenType(R"( "<="">"? )"));
+    EXPECT_EQ(texts("a <= b"), (Texts{"a", "<", "=", "b"}));
+    EXPECT_EQ(l.stats.rules.size(), 3);
+
+    l.opts.ignoreWhitespace = false;
+    EXPECT_THROW(texts("a b"), LexException);
+    EXPECT_EQ(texts("a<b"), (Texts{"a", "<", "b"}));
+    l.opts.ignoreWhitespace = true;
+    EXPECT_EQ(texts("a < b"), (Texts{"a", "<", "b"}));
+
+    l.profile("a <= b = c");
+    l.addTokenType(R"( [0-9]+ )");
+    EXPECT_EQ(l.layout.size(), 4);
+    EXPECT_EQ(texts("a = 12"), (Texts{"a", "=", "12"}));
+
+    // A rule over the limits is rejected without touching the others.
+    l.limits.maxLength = 16;
+    EXPECT_THROW(l.addTokenType(R"( "a_very_long_keyword" )"),
+                 RegexParsing::RegexException);
+    EXPECT_EQ(l.stats.rules.size(), 4);
+    EXPECT_EQ(texts("a = 12"), (Texts{"a", "=", "12"}));
+}
+
+TEST(TestLexer, TokenCache)
+{
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType<DecimalToken>(R"( [0-9]+ )");
+    l.addTokenType<StringToken>(R"( \"(([^"\\\n]|\\.)*)\" )");
+    l.addTokenType(R"( [a-z]+ )");
+    CompiledLexer<Token> compiled = l.compile();
+
+    std::string source = "let s \"a\\\"b\" in\n  f 12 345 \"\" x";
+    std::vector<std::unique_ptr<Token>> expected = compiled.tokenize(source);
+    std::string data = compiled.cache(source);
+    // Whitespace is left out and every span fits in 3 bytes.
+    EXPECT_LE(data.size(), 64 + 3 * expected.size());
+
+    TokenStream<Token> stream(compiled, source, data);
+    ASSERT_TRUE(stream.valid());
+    EXPECT_EQ(stream.size(), expected.size());
+    for (const auto &want : expected) {
+        std::unique_ptr<Token> got = stream.next();
+        ASSERT_NE(got, nullptr);
+        EXPECT_EQ(got->text, want->text);
+        EXPECT_EQ(typeid(*got), typeid(*want));
+    }
+    EXPECT_EQ(stream.next(), nullptr);
+    TokenStream<Token> strings(compiled, source, data);
+    TokenSpan span;
+    while (strings.next(span) && span.rule != 1) {
+    }
+    EXPECT_EQ(strings.text(span), "\"a\\\"b\"");
+    EXPECT_EQ(dynamic_cast<StringToken &>(
+                  *compiled.construct(span.rule, source, span.begin, span.end))
+                  .body,
+              "a\\\"b");
+
+    // Stale or foreign streams are refused.
+    std::string edited = source;
+    edited[0] = 'n';
+    EXPECT_FALSE(TokenStream<Token>(compiled, edited, data).valid());
+    l.addTokenType(R"( "=" )");
+    CompiledLexer<Token> changed = l.compile();
+    EXPECT_FALSE(TokenStream<Token>(changed, source, data).valid());
+    EXPECT_FALSE(
+        TokenStream<Token>(compiled, source, data.substr(0, 10)).valid());
+    // The stream only views its data, which must outlive it.
+    std::string cut = data.substr(0, data.size() - 2);
+    TokenStream<Token> truncated(compiled, source, cut);
+    while (truncated.next() != nullptr) {
+    }
+    EXPECT_FALSE(truncated.valid());
+}
+
+struct IntToken : Token {
+    std::uint64_t val;
+    bool overflow;
+    IntToken(const Payload &payload)
+        : Token(""), val(payload.integer), overflow(payload.overflow)
+    {}
+};
+
+TEST(TestLexer, Payloads)
+{
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType<IntToken>(R"( 0x[0-9a-fA-F]+ )", Payload::Hex);
+    std::vector<double> floats;
+    l.addTokenType(R"( [0-9]+\.[0-9]* )", Payload::Float,
+                   [&floats](const Payload &payload) {
+                       floats.push_back(payload.real);
+                       return nullptr;
+                   });
+    l.addTokenType<IntToken>(R"( [0-9]+ )", Payload::Decimal);
+    l.addTokenType(R"( \"([^"\\\n]|\\.)*\" )", Payload::String,
+                   [](const Payload &payload) {
+                       return std::make_unique<Token>(payload.string);
+                   });
+
+    std::string text = "12 0x1F 0.1 2.5 3. 18446744073709551615 "
+                       "18446744073709551616 \"a\\tb\\\"c\" 1.0000000000000000001";
+    for (int pass = 0; pass < 2; pass++) {
+        floats.clear();
+        std::vector<std::unique_ptr<Token>> tokens;
+        if (pass == 0) {
+            tokens = l.compile().tokenize(text);
+        } else {
+            // Cached tokens are decoded when they are read back.
+            CompiledLexer<Token> compiled = l.compile();
+            std::string data = compiled.cache(text);
+            TokenStream<Token> stream(compiled, text, data);
+            while (std::unique_ptr<Token> t = stream.next()) {
+                tokens.push_back(std::move(t));
+            }
+        }
+        ASSERT_EQ(tokens.size(), 5);
+        EXPECT_EQ(dynamic_cast<IntToken &>(*tokens[0]).val, 12);
+        EXPECT_EQ(dynamic_cast<IntToken &>(*tokens[1]).val, 0x1F);
+        EXPECT_EQ(dynamic_cast<IntToken &>(*tokens[2]).val, UINT64_MAX);
+        EXPECT_FALSE(dynamic_cast<IntToken &>(*tokens[2]).overflow);
+        EXPECT_TRUE(dynamic_cast<IntToken &>(*tokens[3]).overflow);
+        EXPECT_EQ(tokens[4]->text, "a\tb\"c");
+        ASSERT_EQ(floats.size(), 4);
+        EXPECT_EQ(floats[0], 0.1);
+        EXPECT_EQ(floats[1], 2.5);
+        EXPECT_EQ(floats[2], 3.0);
+        EXPECT_EQ(floats[3], 1.0000000000000000001);
+    }
+}
+
+TEST(TestLexer, Relex)
+{
+    Lexer<Token> l;
+    l.opts.ignoreWhitespace = true;
+    l.addTokenType(R"( [a-z]+ )");
+    l.addTokenType(R"( [0-9]+(\.[0-9]+)? )");
+    l.addTokenType(R"( \"([^"\\\n]|\\.)*\" )");
+    l.addTokenType(R"( "="|"=="|";"|"." )");
+    CompiledLexer<Token> compiled = l.compile();
+
+    std::string text;
+    for (int i = 0; i < 200; i++) {
+        text += "let x" + std::string(1, 'a' + i % 26) + " == " +
+                std::to_string(i) + ".5; s = \"str " + std::to_string(i) +
+                "\";\n";
+    }
+    std::vector<TokenSpan> spans = compiled.scan(text);
+
+    const std::vector<std::string> snippets = {"", "1", "a", " ", "\n", "==",
+                                               ".", "9.", "\"", "\" \"",
+                                               "abc def", ";;"};
+    unsigned seed = 1;
+    auto rand = [&seed](std::size_t n) {
+        seed = seed * 1103515245 + 12345;
+        return static_cast<std::size_t>((seed >> 8) % n);
+    };
+    int applied = 0;
+    for (int round = 0; round < 300; round++) {
+        Edit edit;
+        edit.offset = rand(text.size() + 1);
+        edit.removed = std::min(rand(4), text.size() - edit.offset);
+        const std::string &snippet = snippets[rand(snippets.size())];
+        edit.inserted = snippet.size();
+        std::string edited = text;
+        edited.replace(edit.offset, edit.removed, snippet);
+
+        std::vector<TokenSpan> expected;
+        try {
+            expected = compiled.scan(edited);
+        } catch (const LexException &) {
+            EXPECT_THROW(compiled.relex(spans, edited, edit), LexException);
+            continue;
+        }
+        TokenDelta delta = compiled.relex(spans, edited, edit);
+        // A small edit only touches a few tokens, unless it opens or
+        // closes a string.
+        if (snippet.find('"') == std::string::npos) {
+            EXPECT_LE(delta.removed + delta.inserted.size(), 12)
+                << "edit at " << edit.offset;
+        }
+        delta.apply(spans);
+        ASSERT_EQ(spans.size(), expected.size()) << "round " << round;
+        for (std::size_t i = 0; i < spans.size(); i++) {
+            ASSERT_EQ(spans[i].begin, expected[i].begin) << "round " << round;
+            ASSERT_EQ(spans[i].end, expected[i].end);
+            ASSERT_EQ(spans[i].rule, expected[i].rule);
+        }
+        text = std::move(edited);
+        applied++;
+    }
+    EXPECT_GT(applied, 150);
+}
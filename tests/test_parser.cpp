@@ -2,18 +2,32 @@
 #include <gtest/gtest.h>
 #include <iostream>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <utility>
+#include <variant>
 #include <vector>
 
+#include "parser/Cst.hpp"
+#include "parser/Earley.hpp"
+#include "parser/Forest.hpp"
+#include "parser/Grammar.hpp"
+#include "parser/LRTable.hpp"
+#include "parser/Packrat.hpp"
+#include "parser/ParseException.hpp"
+#include "parser/ParseTable.hpp"
 #include "parser/Production.hpp"
 #include "parser/Token.hpp"
 
 using namespace parser;
 
 struct TextToken : public Token {
-    TextToken(std::string text) : Token(std::move(text)) {}
-    auto id() -> Token::Id override { return Token::id<TextToken>(); }
+    TextToken(std::string text)
+        : Token(std::move(text), Token::id<TextToken>())
+    {}
 };
 
 void addToken(std::vector<std::unique_ptr<Token>> &tokens,
@@ -72,3 +86,640 @@ TEST(TestParser, IfElse)
 
     std::cout << g.produce(tokens) << "\n";
 }
+
+TEST(TestParser, TokenIds)
+{
+    Token::Id textId = Token::id<TextToken>();
+    Token::Id baseId = Token::id<Token>();
+    EXPECT_NE(textId, baseId);
+    EXPECT_EQ(Token::id<TextToken>(), textId);
+    EXPECT_GE(textId, 0);
+    EXPECT_LT(textId, Token::idCount());
+    EXPECT_LT(baseId, Token::idCount());
+
+    EXPECT_EQ(TextToken("x").id(), textId);
+    EXPECT_EQ(Token("x").id(), baseId);
+}
+
+TEST(TestParser, GrammarSets)
+{
+    // E -> E + T | T
+    // T -> x | ( E )
+    // O -> A B
+    // A -> a |
+    // B -> b |
+    Production e("e");
+    Production t("t");
+    e.add({&e, '+', &t});
+    e.add({&t});
+    t.add({'x'});
+    t.add({'(', &e, ')'});
+    e.finalize();
+
+    using Set = std::unordered_set<Production::Symbol>;
+    const Grammar &eg = e.grammar();
+    EXPECT_FALSE(e.nullable());
+    EXPECT_EQ(e.first(), (Set{'x', '('}));
+    EXPECT_EQ(t.first(), (Set{'x', '('}));
+    EXPECT_EQ(eg.follow(0), (Set{'+', ')'}));
+    EXPECT_EQ(eg.follow(eg.row(t)), (Set{'+', ')'}));
+    EXPECT_TRUE(eg.canEnd(0));
+    EXPECT_TRUE(eg.canEnd(eg.row(t)));
+
+    Production o("o");
+    Production a("a");
+    Production b("b");
+    o.add({&a, &b, "end"});
+    a.add({'a'});
+    a.add({});
+    b.add({'b'});
+    b.add({});
+    EXPECT_TRUE(a.nullable());
+    o.finalize();
+    const Grammar &og = o.grammar();
+    EXPECT_FALSE(o.nullable());
+    EXPECT_EQ(o.first(), (Set{'a', 'b', std::string("end")}));
+    EXPECT_EQ(og.follow(og.row(a)), (Set{'b', std::string("end")}));
+    EXPECT_EQ(og.follow(og.row(b)), (Set{std::string("end")}));
+    EXPECT_FALSE(og.canEnd(og.row(a)));
+    EXPECT_EQ(og.row(e), Grammar::none);
+
+    // FOLLOW is relative to the goal: taken as its own goal, a can end.
+    EXPECT_TRUE(a.grammar().canEnd(0));
+    EXPECT_TRUE(a.grammar().follow(0).empty());
+
+    // A grammar is fixed once built, so the productions it reaches refuse
+    // new rules, a included since its own nullable() built one. Productions
+    // it does not reach, and new goals over the fixed ones, are fine.
+    EXPECT_THROW(b.add({Token::id<TextToken>()}), std::logic_error);
+    EXPECT_THROW(a.add({'c'}), std::logic_error);
+    EXPECT_EQ(o.first(), (Set{'a', 'b', std::string("end")}));
+    Production c("c");
+    c.add({'c'});
+    Production o2("o2");
+    o2.add({&a, &b, &c});
+    EXPECT_EQ(o2.first(), (Set{'a', 'b', 'c'}));
+}
+
+TEST(TestParser, DeepGrammar)
+{
+    // P0 -> P1 | P1 y, P1 -> P2 | P2 y, ..., Pn -> x. Recomputing the sets
+    // while parsing would take 2^n steps here.
+    constexpr int depth = 64;
+    std::vector<Production> prods(depth + 1);
+    for (int i = 0; i < depth; i++) {
+        prods[i].add({&prods[i + 1]});
+        prods[i].add({&prods[i + 1], 'y'});
+    }
+    prods[depth].add({'x'});
+
+    std::vector<std::unique_ptr<Token>> tokens;
+    addToken(tokens, "x");
+    Production::Node n = prods[0].produce(tokens);
+    ASSERT_TRUE(std::holds_alternative<Terminal>(n));
+    EXPECT_EQ(std::get<Terminal>(n).literal->text, "x");
+}
+
+TEST(TestParser, SharedGoal)
+{
+    // S -> x S | ;, parsed from several threads before its grammar is built.
+    Production s("s");
+    s.add({'x', &s});
+    s.add({';'});
+    auto input = [] {
+        std::vector<std::unique_ptr<Token>> tokens;
+        for (int i = 0; i < 100; i++) {
+            addToken(tokens, "x");
+        }
+        addToken(tokens, ";");
+        return tokens;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::size_t> counts(4);
+    for (std::size_t t = 0; t < counts.size(); t++) {
+        workers.emplace_back([&s, &input, &counts, t]() {
+            std::vector<std::unique_ptr<Token>> tokens = input();
+            counts[t] = s.produceCst(tokens).nodes().size();
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    std::vector<std::unique_ptr<Token>> tokens = input();
+    for (std::size_t count : counts) {
+        EXPECT_EQ(count, s.produceCst(tokens).nodes().size());
+        tokens = input();
+    }
+}
+
+TEST(TestParser, ParseTable)
+{
+    // S -> kw0 ; | kw1 ; | ... | x S | ;
+    Production s("s");
+    constexpr int keywords = 32;
+    for (int i = 0; i < keywords; i++) {
+        s.add({"kw" + std::to_string(i), ';'});
+    }
+    s.add({Token::id<TextToken>(), &s});
+    s.add({});
+    s.finalize();
+    EXPECT_TRUE(s.table().conflicts().empty());
+    EXPECT_EQ(s.table().rule(0, nullptr), keywords + 1);
+    TextToken kw("kw7");
+    EXPECT_EQ(s.table().rule(0, &kw), 7);
+    Token other(";");
+    EXPECT_EQ(s.table().rule(0, &other), keywords + 1);
+
+    std::vector<std::unique_ptr<Token>> tokens;
+    tokens.push_back(std::make_unique<Token>("kw31"));
+    tokens.push_back(std::make_unique<Token>(";"));
+    Production::Node n = s.produce(tokens);
+    ASSERT_TRUE(std::holds_alternative<NonTerminal>(n));
+    EXPECT_EQ(std::get<Terminal>(std::get<NonTerminal>(n).children[0])
+                  .literal->text,
+              "kw31");
+
+    // A -> x | "x" y | B, B -> | C, C ->
+    Production a("a");
+    Production b("b");
+    Production c("c");
+    a.add({'x'});
+    a.add({"x", 'y'});
+    a.add({&b});
+    b.add({});
+    b.add({&c});
+    c.add({});
+    a.finalize();
+    const std::vector<ParseTable::Conflict> &conflicts = a.table().conflicts();
+    ASSERT_EQ(conflicts.size(), 2);
+    EXPECT_EQ(conflicts[0].production, &a);
+    EXPECT_EQ(conflicts[0].rule, 0);
+    EXPECT_EQ(conflicts[0].other, 1);
+    EXPECT_EQ(conflicts[1].production, &b);
+    EXPECT_FALSE(conflicts[1].lookahead);
+    std::stringstream ss;
+    ss << conflicts[1];
+    EXPECT_EQ(ss.str(),
+              "Production(b): rules 0 and 1 both expand on end of input");
+
+    // E -> | x, T -> E x. An empty rule is only chosen on FOLLOW, so a
+    // later rule is still taken on its FIRST elsewhere: as a goal E expands
+    // to x, while inside T the empty rule wins the conflict on x.
+    Production e("e");
+    Production t("t");
+    e.add({});
+    e.add({'x'});
+    t.add({&e, 'x'});
+    tokens.clear();
+    addToken(tokens, "x");
+    n = e.produce(tokens);
+    ASSERT_TRUE(std::holds_alternative<Terminal>(n));
+    EXPECT_EQ(std::get<Terminal>(n).literal->text, "x");
+    tokens.clear();
+    EXPECT_TRUE(std::holds_alternative<Epsilon>(e.produce(tokens)));
+    ASSERT_EQ(t.table().conflicts().size(), 1);
+    EXPECT_EQ(t.table().conflicts()[0].rule, 0);
+    tokens.clear();
+    addToken(tokens, "x");
+    n = t.produce(tokens);
+    ASSERT_TRUE(std::holds_alternative<Terminal>(n));
+    EXPECT_EQ(std::get<Terminal>(n).literal->text, "x");
+}
+
+static auto printed(const Production::Node &n) -> std::string
+{
+    std::stringstream ss;
+    ss << n;
+    return ss.str();
+}
+
+TEST(TestParser, LRTable)
+{
+    // E -> E + T | T
+    // T -> T * F | F
+    // F -> x | ( E )
+    Production e("e");
+    Production t("t");
+    Production f("f");
+    e.add({&e, '+', &t});
+    e.add({&t});
+    t.add({&t, '*', &f});
+    t.add({&f});
+    f.add({'x'});
+    f.add({'(', &e, ')'});
+    LRTable table(e);
+    EXPECT_TRUE(table.conflicts().empty());
+    EXPECT_LT(table.rowCount(), table.stateCount());
+
+    // x+x*(x+x)
+    std::vector<std::unique_ptr<Token>> tokens;
+    for (const char *text : {"x", "+", "x", "*", "(", "x", "+", "x", ")"}) {
+        addToken(tokens, text);
+    }
+    Production::Node n = table.parse(tokens);
+    const auto &sum = std::get<NonTerminal>(n).children;
+    ASSERT_EQ(sum.size(), 3);
+    EXPECT_EQ(std::get<Terminal>(sum[0]).literal->text, "x");
+    const auto &product = std::get<NonTerminal>(sum[2]).children;
+    ASSERT_EQ(product.size(), 3);
+    EXPECT_EQ(std::get<Terminal>(product[1]).literal->text, "*");
+    EXPECT_EQ(std::get<NonTerminal>(product[2]).children.size(), 3);
+
+    tokens.clear();
+    addToken(tokens, "x");
+    addToken(tokens, "x");
+    try {
+        table.parse(tokens);
+        FAIL();
+    } catch (const ParseException &ex) {
+        EXPECT_EQ(std::string(ex.what()),
+                  "Parse error at token 2: Found Token(x): Expected one of end "
+                  "of input Symbol('+') Symbol('*') Symbol(')')");
+    }
+
+    // A left-recursive list never recurses, however long.
+    Production list("list");
+    list.add({&list, Token::id<TextToken>()});
+    list.add({});
+    tokens.clear();
+    for (int i = 0; i < 100000; i++) {
+        addToken(tokens, "a");
+    }
+    n = LRTable(list).parse(tokens);
+    std::size_t length = 1;
+    const Production::Node *node = &n;
+    while (std::holds_alternative<NonTerminal>(*node)) {
+        node = &std::get<NonTerminal>(*node).children.front();
+        length++;
+    }
+    EXPECT_EQ(length, 100000);
+}
+
+TEST(TestParser, LRTableMatchesProduce)
+{
+    Production g("g");
+    Production g1("g1");
+    Production s("s");
+    Production s1("s1");
+    Production l("l");
+    Production l1("l1");
+    g.add({"if", &s, &g1});
+    g1.add({"else", &s});
+    g1.add({});
+    s.add({'s'});
+    s.add({'{', &s1});
+    s1.add({&l, '}'});
+    s1.add({'}'});
+    l.add({&s, &l1});
+    l1.add({&l});
+    l1.add({});
+
+    auto tokens = [] {
+        std::vector<std::unique_ptr<Token>> tokens;
+        for (const char *text : {"if", "{", "s", "{", "{", "}", "s", "}", "s",
+                                 "}", "else", "{", "s", "s", "}"})
+        {
+            addToken(tokens, text);
+        }
+        return tokens;
+    };
+    std::vector<std::unique_ptr<Token>> a = tokens();
+    std::vector<std::unique_ptr<Token>> b = tokens();
+    EXPECT_EQ(printed(LRTable(g).parse(a)), printed(g.produce(b)));
+}
+
+TEST(TestParser, LRTableConflicts)
+{
+    // S -> if S | if S else S | s
+    Production s("s");
+    s.add({"if", &s});
+    s.add({"if", &s, "else", &s});
+    s.add({'s'});
+    LRTable table(s);
+    ASSERT_EQ(table.conflicts().size(), 1);
+    const LRTable::Conflict &c = table.conflicts()[0];
+    EXPECT_TRUE(c.shift);
+    EXPECT_EQ(c.production, &s);
+    EXPECT_EQ(c.rule, 0);
+    std::stringstream ss;
+    ss << c;
+    EXPECT_EQ(ss.str().substr(ss.str().find(" on ")),
+              " on Symbol(\"else\"): shift over reducing Production(s) by "
+              "rule 0");
+
+    // The else goes with the nearest if.
+    std::vector<std::unique_ptr<Token>> tokens;
+    for (const char *text : {"if", "if", "s", "else", "s"}) {
+        addToken(tokens, text);
+    }
+    Production::Node n = table.parse(tokens);
+    const auto &outer = std::get<NonTerminal>(n).children;
+    ASSERT_EQ(outer.size(), 2);
+    EXPECT_EQ(std::get<NonTerminal>(outer[1]).children.size(), 4);
+}
+
+TEST(TestParser, Packrat)
+{
+    // S -> A x | A y
+    // A -> a A | a
+    // Not LL(1): both rules of each start with a.
+    Production s("s");
+    Production a("a");
+    s.add({&a, 'x'});
+    s.add({&a, 'y'});
+    a.add({'a', &a});
+    a.add({'a'});
+
+    std::vector<std::unique_ptr<Token>> tokens;
+    for (const char *text : {"a", "a", "y"}) {
+        addToken(tokens, text);
+    }
+    Packrat packrat(s);
+    EXPECT_EQ(printed(packrat.parse(tokens)),
+              "NonTerminal[\n"
+              "  NonTerminal[\n"
+              "    Terminal(Token(a))\n"
+              "    Terminal(Token(a))\n"
+              "  ]\n"
+              "  Terminal(Token(y))\n"
+              "]");
+    EXPECT_GT(packrat.hits, 0);
+
+    tokens.clear();
+    for (const char *text : {"a", "a", "z"}) {
+        addToken(tokens, text);
+    }
+    try {
+        packrat.parse(tokens);
+        FAIL();
+    } catch (const ParseException &ex) {
+        EXPECT_EQ(std::string(ex.what()),
+                  "Parse error at token 3: Found Token(z)");
+    }
+
+    // Left recursion does not match, so the second rule is taken.
+    Production list("list");
+    list.add({&list, 'a'});
+    list.add({'a'});
+    tokens.clear();
+    addToken(tokens, "a");
+    EXPECT_EQ(printed(Packrat(list).parse(tokens)), "Terminal(Token(a))");
+}
+
+TEST(TestParser, PackratMemo)
+{
+    // E -> T + E | T - E | T
+    // T -> ( E ) | n
+    // Without the memo each level of parentheses is matched three times.
+    Production e("e");
+    Production t("t");
+    e.add({&t, '+', &e});
+    e.add({&t, '-', &e});
+    e.add({&t});
+    t.add({'(', &e, ')'});
+    t.add({'n'});
+
+    constexpr int depth = 10;
+    auto tokens = [] {
+        std::vector<std::unique_ptr<Token>> tokens;
+        for (int i = 0; i < depth; i++) {
+            addToken(tokens, "(");
+        }
+        addToken(tokens, "n");
+        for (int i = 0; i < depth; i++) {
+            addToken(tokens, ")");
+        }
+        return tokens;
+    };
+    std::vector<std::unique_ptr<Token>> in = tokens();
+    std::string expected = printed(Packrat(e).parse(in));
+
+    // A memo too small for the input still gives the same tree, if slower.
+    Packrat small(e, 4);
+    in = tokens();
+    EXPECT_EQ(printed(small.parse(in)), expected);
+    EXPECT_GT(small.evictions, 0);
+
+    // The input is consumed without recursion, however long.
+    Production list("list");
+    list.add({'a', &list});
+    list.add({});
+    std::vector<std::unique_ptr<Token>> many;
+    for (int i = 0; i < 100000; i++) {
+        addToken(many, "a");
+    }
+    Packrat packrat(list, 16);
+    Production::Node n = packrat.parse(many);
+    EXPECT_GT(packrat.evictions, 0);
+    EXPECT_EQ(std::get<NonTerminal>(n).children.size(), 2);
+}
+
+TEST(TestParser, Earley)
+{
+    // E -> E + E | x
+    // Every way of bracketing the sums is a parse.
+    Production e("e");
+    e.add({&e, '+', &e});
+    e.add({'x'});
+    auto sums = [](int count) {
+        std::vector<std::unique_ptr<Token>> tokens;
+        addToken(tokens, "x");
+        for (int i = 0; i < count; i++) {
+            addToken(tokens, "+");
+            addToken(tokens, "x");
+        }
+        return tokens;
+    };
+    Earley earley(e);
+    std::vector<std::unique_ptr<Token>> tokens = sums(3);
+    Forest f = earley.parse(tokens);
+    EXPECT_TRUE(f.ambiguous());
+    EXPECT_EQ(f.treeCount(), 5);
+    Production::Node n = f.tree(tokens);
+    EXPECT_EQ(std::get<NonTerminal>(n).children.size(), 3);
+
+    // The Catalan number of parses, in a forest of polynomial size.
+    tokens = sums(20);
+    f = earley.parse(tokens);
+    EXPECT_EQ(f.treeCount(), 6564120420ul);
+    EXPECT_LT(f.symbols().size(), 41 * 41);
+
+    tokens = sums(1);
+    tokens.pop_back();
+    try {
+        earley.parse(tokens);
+        FAIL();
+    } catch (const ParseException &ex) {
+        EXPECT_EQ(std::string(ex.what()),
+                  "Parse error at token 2: Unexpected end of input");
+    }
+    addToken(tokens, "+");
+    try {
+        earley.parse(tokens);
+        FAIL();
+    } catch (const ParseException &ex) {
+        EXPECT_EQ(std::string(ex.what()),
+                  "Parse error at token 3: Found Token(+)");
+    }
+
+    // Left recursion and empty rules.
+    Production list("list");
+    list.add({&list, 'a'});
+    list.add({});
+    tokens.clear();
+    for (int i = 0; i < 3; i++) {
+        addToken(tokens, "a");
+    }
+    f = Earley(list).parse(tokens);
+    EXPECT_FALSE(f.ambiguous());
+    EXPECT_EQ(printed(f.tree(tokens)),
+              "NonTerminal[\n"
+              "  NonTerminal[\n"
+              "    Terminal(Token(a))\n"
+              "    Terminal(Token(a))\n"
+              "  ]\n"
+              "  Terminal(Token(a))\n"
+              "]");
+}
+
+TEST(TestParser, EarleyMatchesPackrat)
+{
+    // S -> A x | A y
+    // A -> a A | a
+    Production s("s");
+    Production a("a");
+    s.add({&a, 'x'});
+    s.add({&a, 'y'});
+    a.add({'a', &a});
+    a.add({'a'});
+
+    auto tokens = [] {
+        std::vector<std::unique_ptr<Token>> tokens;
+        for (const char *text : {"a", "a", "a", "y"}) {
+            addToken(tokens, text);
+        }
+        return tokens;
+    };
+    std::vector<std::unique_ptr<Token>> in = tokens();
+    Forest f = Earley(s).parse(in);
+    EXPECT_EQ(f.treeCount(), 1);
+    std::vector<std::unique_ptr<Token>> other = tokens();
+    EXPECT_EQ(printed(f.tree(in)), printed(Packrat(s).parse(other)));
+}
+
+TEST(TestParser, EarleyRightRecursion)
+{
+    // Leo's optimization keeps the sets small on right recursion, where
+    // every set would otherwise hold an item for each level below it.
+    Production list("list");
+    list.add({'a', &list});
+    list.add({});
+    constexpr int count = 10000;
+    std::vector<std::unique_ptr<Token>> tokens;
+    for (int i = 0; i < count; i++) {
+        addToken(tokens, "a");
+    }
+    Earley earley(list);
+    Forest f = earley.parse(tokens);
+    EXPECT_LT(earley.itemCount, 10 * count);
+    EXPECT_EQ(f.treeCount(), 1);
+    Production::Node n = f.tree(tokens);
+    EXPECT_EQ(std::get<NonTerminal>(n).children.size(), 2);
+
+    // S -> B B | b | X a
+    // B -> b
+    // X -> S
+    // A Leo chain through S -> B B would go on to X -> S, skipping the
+    // completion of the goal.
+    Production s("s");
+    Production b("b");
+    Production x("x");
+    s.add({&b, &b});
+    s.add({'b'});
+    s.add({&x, 'a'});
+    b.add({'b'});
+    x.add({&s});
+    tokens.clear();
+    addToken(tokens, "b");
+    addToken(tokens, "b");
+    f = Earley(s).parse(tokens);
+    EXPECT_EQ(f.treeCount(), 1);
+    EXPECT_EQ(printed(f.tree(tokens)),
+              "NonTerminal[\n"
+              "  Terminal(Token(b))\n"
+              "  Terminal(Token(b))\n"
+              "]");
+    tokens.clear();
+    for (const char *text : {"b", "a"}) {
+        addToken(tokens, text);
+    }
+    EXPECT_EQ(Earley(s).parse(tokens).treeCount(), 1);
+}
+
+TEST(TestParser, Cst)
+{
+    // E -> T E'
+    // E' -> + T E' | (epsilon)
+    // T -> x | ( E )
+    Production e("e");
+    Production e1("e1");
+    Production t("t");
+    e.add({&t, &e1});
+    e1.add({'+', &t, &e1});
+    e1.add({});
+    t.add({'x'});
+    t.add({'(', &e, ')'});
+
+    std::vector<std::unique_ptr<Token>> tokens;
+    for (const char *text : {"x", "+", "x"}) {
+        addToken(tokens, text);
+    }
+    Cst cst = e.produceCst(tokens);
+    std::stringstream ss;
+    ss << cst;
+    EXPECT_EQ(ss.str(),
+              "Production(e)[\n"
+              "  Production(t)[\n"
+              "    Terminal(Token(x))\n"
+              "  ]\n"
+              "  Production(e1)[\n"
+              "    Terminal(Token(+))\n"
+              "    Production(t)[\n"
+              "      Terminal(Token(x))\n"
+              "    ]\n"
+              "    Production(e1)[]\n"
+              "  ]\n"
+              "]");
+    EXPECT_EQ(cst.nodes().size(), 8);
+    EXPECT_EQ(cst.tokens().size(), 3);
+    EXPECT_EQ(cst.productions().size(), 3);
+    EXPECT_EQ(&cst.production(cst.root()), &e);
+
+    // Children come before their parents.
+    std::vector<std::uint32_t> kids;
+    for (std::uint32_t c : cst.children(cst.root())) {
+        kids.push_back(c);
+        EXPECT_LT(c, cst.root());
+    }
+    ASSERT_EQ(kids.size(), 2);
+    EXPECT_EQ(&cst.production(kids[0]), &t);
+    EXPECT_EQ(&cst.production(kids[1]), &e1);
+    std::uint32_t x = *cst.children(kids[0]).begin();
+    EXPECT_EQ(cst.nodes()[x].kind, Cst::Kind::Terminal);
+    EXPECT_EQ(cst.token(x).text, "x");
+
+    // Deep input is built and freed without recursion.
+    constexpr int depth = 100000;
+    tokens.clear();
+    for (int i = 0; i < depth; i++) {
+        addToken(tokens, "(");
+    }
+    addToken(tokens, "x");
+    for (int i = 0; i < depth; i++) {
+        addToken(tokens, ")");
+    }
+    cst = e.produceCst(tokens);
+    EXPECT_EQ(cst.nodes().size(), 5 * depth + 4);
+    EXPECT_EQ(cst.tokens().size(), 2 * depth + 1);
+}
@@ -1,11 +1,19 @@
 #include <cassert>
 #include <cctype>
+#include <chrono>
 #include <gtest/gtest.h>
+#include <cstdio>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
 #include <string>
 #include <vector>
 
+#include "lexer/Matcher.hpp"
 #include "lexer/RegexParsing.hpp"
+#include "lexer/State.hpp"
+#include "lexer/StateMachine.hpp"
 
 void printTokens(const std::vector<int> &tokens)
 {
@@ -108,3 +116,261 @@ TEST_F(TestRegex, Construction)
         RegexParsing::Pattern p(test);
     }
 }
+
+static auto fullMatch(const lexer::StateMachine &sm, const std::string &text)
+    -> bool
+{
+    int state = lexer::State::Enter;
+    for (char c : text) {
+        state = sm.transition(state, c);
+        if (state == lexer::State::Accept || state == lexer::State::Reject) {
+            return false;
+        }
+    }
+    return sm.transition(state, static_cast<char>(EOF)) == lexer::State::Accept;
+}
+
+// Where a machine stops on text followed by EOF: the byte it accepted or
+// rejected at, negated for a reject.
+static auto stop(const lexer::StateMachine &sm, const std::string &text)
+    -> long
+{
+    int state = lexer::State::Enter;
+    for (std::size_t i = 0; i <= text.size(); i++) {
+        char c = i < text.size() ? text[i] : static_cast<char>(EOF);
+        state = sm.transition(state, c);
+        if (state == lexer::State::Accept) {
+            return static_cast<long>(i);
+        }
+        if (state == lexer::State::Reject) {
+            return -static_cast<long>(i) - 1;
+        }
+    }
+    return -static_cast<long>(text.size()) - 2;
+}
+
+// Expects the optimized machine for regex to stop where the plain one does
+// on every string over alphabet up to length.
+static void expectSameStops(const std::string &regex,
+                            const std::string &alphabet,
+                            std::size_t length)
+{
+    auto p = std::make_shared<RegexParsing::Pattern>(regex);
+    lexer::StateMachine plain(RegexParsing::toNode(p));
+    lexer::StateMachine optimized(
+        RegexParsing::toNode(RegexParsing::optimize(p)));
+    EXPECT_LE(optimized.states.size(), plain.states.size()) << regex;
+    std::vector<std::string> texts = {""};
+    for (std::size_t k = 0; k < texts.size(); k++) {
+        EXPECT_EQ(stop(optimized, texts[k]), stop(plain, texts[k]))
+            << regex << " on \"" << texts[k] << "\"";
+        if (texts[k].size() < length) {
+            for (char c : alphabet) {
+                texts.push_back(texts[k] + c);
+            }
+        }
+    }
+}
+
+TEST_F(TestRegex, Optimization)
+{
+    RegexParsing::debug = false;
+    struct Case {
+        std::string regex;
+        std::vector<std::string> matching;
+        std::vector<std::string> failing;
+    };
+    // A rule takes the first alternative that matches a byte, so "in" and
+    // "int" are never reached behind "if".
+    std::vector<Case> cases = {
+        {R"("let"|"if"|"in"|"int")", {"let", "if"}, {"in", "int", "i", "le"}},
+        {R"("a"|"ab"|"abc")", {"a"}, {"ab", "abc"}},
+        {R"("b"|[ab]b|"cb")", {"b", "ab", "cb"}, {"a", "bb"}},
+        {R"(a|b|c|[x-z])", {"a", "c", "y"}, {"d", "ab"}},
+        {R"((a*)*b)", {"b", "ab", "aaab"}, {"a", "ba"}},
+        {R"((a+)?c)", {"c", "aac"}, {"a", "cc"}},
+        {R"(x(ab|cb)y)", {"xaby", "xcby"}, {"xby", "xacy"}},
+        {R"(a*a*b)", {"b", "aab"}, {"a"}},
+    };
+    for (const Case &c : cases) {
+        std::cout << "\x1B[90m>\x1B[0m " << c.regex << "\n";
+        auto p = std::make_shared<RegexParsing::Pattern>(c.regex);
+        lexer::StateMachine optimized(
+            RegexParsing::toNode(RegexParsing::optimize(p)));
+        for (const std::string &text : c.matching) {
+            EXPECT_TRUE(fullMatch(optimized, text)) << text;
+        }
+        for (const std::string &text : c.failing) {
+            EXPECT_FALSE(fullMatch(optimized, text)) << text;
+        }
+        expectSameStops(c.regex, "abcilnt", 4);
+    }
+
+    auto keywords =
+        std::make_shared<RegexParsing::Pattern>(R"("if"|"in"|"int"|"for")");
+    EXPECT_LT(lexer::StateMachine(
+                  RegexParsing::toNode(RegexParsing::optimize(keywords)))
+                  .states.size(),
+              lexer::StateMachine(RegexParsing::toNode(keywords)).states.size());
+    auto suffixes =
+        std::make_shared<RegexParsing::Pattern>(R"("ab"|"cb"|"db")");
+    EXPECT_LT(lexer::StateMachine(
+                  RegexParsing::toNode(RegexParsing::optimize(suffixes)))
+                  .states.size(),
+              lexer::StateMachine(RegexParsing::toNode(suffixes)).states.size());
+}
+
+// Random regexes over a, b and c, built from a fixed seed.
+static auto randomRegex(std::mt19937 &rng, int depth) -> std::string
+{
+    auto pick = [&](int n) {
+        return static_cast<int>(rng() % static_cast<unsigned>(n));
+    };
+    std::string alternation;
+    for (int a = pick(depth > 0 ? 3 : 2); a >= 0; a--) {
+        std::string sequence;
+        for (int s = pick(3); s >= 0; s--) {
+            static const char *const leaves[] = {"a", "b", "c", "[ab]", "\"ab\""};
+            std::string atom = depth > 0 && pick(3) == 0
+                                 ? "(" + randomRegex(rng, depth - 1) + ")"
+                                 : leaves[pick(5)];
+            static const char *const quantifiers[] = {"", "", "", "*", "+", "?"};
+            sequence += atom + quantifiers[pick(6)];
+        }
+        alternation += alternation.empty() ? sequence : "|" + sequence;
+    }
+    return alternation;
+}
+
+TEST_F(TestRegex, OptimizationKeepsStops)
+{
+    RegexParsing::debug = false;
+    std::mt19937 rng(31);
+    for (int k = 0; k < 400; k++) {
+        expectSameStops(randomRegex(rng, 2), "abc", 4);
+    }
+}
+
+TEST_F(TestRegex, Matcher)
+{
+    RegexParsing::debug = false;
+    using Match = RegexParsing::Matcher::Match;
+
+    RegexParsing::Matcher ident(R"([a-zA-Z_][a-zA-Z0-9_]*)");
+    EXPECT_TRUE(ident.fullMatch("foo_1"));
+    EXPECT_FALSE(ident.fullMatch("1foo"));
+    EXPECT_FALSE(ident.fullMatch(""));
+
+    // Unlike a lexer rule, a Matcher backtracks into alternatives.
+    RegexParsing::Matcher alt(R"((ab|a)b)");
+    EXPECT_TRUE(alt.fullMatch("ab"));
+    EXPECT_TRUE(alt.fullMatch("abb"));
+
+    std::string log = "12:00 error: disk full\n12:01 ok\n12:02 error: timeout\n";
+    RegexParsing::Matcher error(R"("error: "[a-z ]+)");
+    std::optional<Match> m = error.search(log);
+    ASSERT_TRUE(m.has_value());
+    EXPECT_EQ(log.substr(m->begin, m->end - m->begin), "error: disk full");
+    m = error.search(log, m->end);
+    ASSERT_TRUE(m.has_value());
+    EXPECT_EQ(log.substr(m->begin, m->end - m->begin), "error: timeout");
+    EXPECT_FALSE(error.search(log, m->end).has_value());
+    EXPECT_FALSE(error.search("no errors here").has_value());
+
+    std::vector<Match> matches;
+    RegexParsing::Matcher digits(R"([0-9]+)");
+    EXPECT_EQ(digits.findAll(log, matches), 6);
+    EXPECT_EQ(matches[0].begin, 0);
+    EXPECT_EQ(matches[0].end, 2);
+    EXPECT_EQ(matches[5].begin, log.find("12:02") + 3);
+    // Results are appended, so the vector can be reused.
+    EXPECT_EQ(digits.findAll("a1b22", matches), 2);
+    EXPECT_EQ(matches.size(), 8);
+    EXPECT_EQ(matches[7].begin, 3);
+    EXPECT_EQ(matches[7].end, 5);
+
+    // A pattern that matches the empty string still makes progress.
+    matches.clear();
+    RegexParsing::Matcher optionalA(R"(a*)");
+    EXPECT_EQ(optionalA.findAll("baab", matches), 4);
+    EXPECT_EQ(matches[1].begin, 1);
+    EXPECT_EQ(matches[1].end, 3);
+}
+
+TEST_F(TestRegex, Limits)
+{
+    using RegexParsing::Budget;
+    using RegexParsing::Limits;
+    using RegexParsing::RegexException;
+
+    auto kindOf = [](const std::string &regex, const Limits &limits) {
+        try {
+            RegexParsing::toNode(regex, Budget(limits));
+        } catch (const RegexException &e) {
+            return static_cast<int>(e.kind());
+        }
+        return -1;
+    };
+
+    EXPECT_EQ(kindOf("a(b", Limits()), RegexException::Invalid);
+    EXPECT_EQ(kindOf("ab\\", Limits()), RegexException::Invalid);
+    EXPECT_EQ(kindOf("(?)", Limits()), RegexException::Invalid);
+    EXPECT_THROW(RegexParsing::Pattern("a|"), RegexException);
+
+    Limits limits;
+    limits.maxLength = 8;
+    EXPECT_EQ(kindOf("abcdefgh", limits), -1);
+    EXPECT_EQ(kindOf("abcdefghi", limits), RegexException::TooLong);
+
+    limits = Limits();
+    limits.maxNesting = 2;
+    EXPECT_EQ(kindOf("((a)b)", limits), -1);
+    EXPECT_EQ(kindOf("(((a)))", limits), RegexException::TooDeep);
+
+    limits = Limits();
+    limits.maxNfaStates = 20;
+    EXPECT_EQ(kindOf("[a-z]+", limits), -1);
+    EXPECT_EQ(kindOf(std::string(40, 'x'), limits),
+              RegexException::TooManyNfaStates);
+
+    // (a|b)*a(a|b)^n needs 2^n states once determinized.
+    std::string blowup = "(a|b)*a";
+    for (int i = 0; i < 12; i++) {
+        blowup += "(a|b)";
+    }
+    limits = Limits();
+    limits.maxDfaStates = 1000;
+    try {
+        RegexParsing::Matcher m(blowup, limits);
+        FAIL() << "expected a RegexException";
+    } catch (const RegexException &e) {
+        EXPECT_EQ(e.kind(), RegexException::TooManyDfaStates) << e.what();
+    }
+
+    // A budget started before its whole allowance times out at the first
+    // check.
+    limits = Limits();
+    limits.maxCompileTime = std::chrono::milliseconds(1);
+    Budget late(limits,
+                std::chrono::steady_clock::now() - std::chrono::seconds(1));
+    try {
+        RegexParsing::toNode("(a|b)*c", late);
+        FAIL() << "expected a RegexException";
+    } catch (const RegexException &e) {
+        EXPECT_EQ(e.kind(), RegexException::Timeout) << e.what();
+    }
+
+    // The default limits reject patterns long or deep enough to exhaust the
+    // stack, instead of crashing.
+    EXPECT_EQ(kindOf(std::string(100000, 'a'), Limits()),
+              RegexException::TooLong);
+    std::string deep =
+        std::string(100000, '(') + "a" + std::string(100000, ')');
+    EXPECT_EQ(kindOf(deep, Limits()), RegexException::TooLong);
+    limits = Limits();
+    limits.maxLength = 0;
+    EXPECT_EQ(kindOf(std::string(1000, '(') + "a" + std::string(1000, ')'),
+                     limits),
+              RegexException::TooDeep);
+    EXPECT_EQ(kindOf(std::string(Limits().maxLength, 'a'), Limits()), -1);
+}